@@ -0,0 +1,34 @@
+#include <atomic>
+
+#include "arena.h"
+
+namespace memory {
+    namespace {
+        std::atomic<ArenaMode> arena_mode{ArenaMode::OFF};
+
+        // Блоки арены учитываются отчётом о памяти и при большом размере попадают в huge pages
+        void* AllocateArenaBlock(size_t bytes) {
+            return AllocateLarge(bytes);
+        }
+
+        void DeallocateArenaBlock(void* pointer, size_t bytes) {
+            DeallocateLarge(pointer, bytes);
+        }
+    }
+
+    void SetArenaMode(ArenaMode mode) {
+        arena_mode = mode;
+    }
+
+    ArenaMode GetArenaMode() {
+        return arena_mode;
+    }
+
+    google::protobuf::ArenaOptions GetArenaOptions() {
+        google::protobuf::ArenaOptions options;
+        options.max_block_size = HUGE_PAGE_SIZE;
+        options.block_alloc = AllocateArenaBlock;
+        options.block_dealloc = DeallocateArenaBlock;
+        return options;
+    }
+}  // namespace memory
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <memory>
+
+#include <google/protobuf/arena.h>
+
+#include "huge_pages.h"
+
+namespace memory {
+    // Размещение сообщений базы Protobuf
+    enum class ArenaMode {
+        OFF,  // каждое вложенное сообщение и строка - отдельный блок кучи
+        ON    // сообщение со всеми вложенными размещается в больших блоках арены и освобождается разом
+    };
+
+    void SetArenaMode(ArenaMode mode);
+    [[nodiscard]] ArenaMode GetArenaMode();
+    // Настройки арены: блоки растут до HUGE_PAGE_SIZE и выделяются через AllocateLarge
+    [[nodiscard]] google::protobuf::ArenaOptions GetArenaOptions();
+
+    // Сообщение Protobuf, размещённое по режиму, действовавшему при его создании. Арена принадлежит сообщению
+    template <typename Message>
+    class ArenaMessage {
+    public:
+        ArenaMessage();
+
+        Message& operator*() const;
+        Message* operator->() const;
+
+    private:
+        std::unique_ptr<google::protobuf::Arena> arena_;
+        std::unique_ptr<Message> heap_message_;
+        Message* message_;
+    };
+
+    template <typename Message>
+    ArenaMessage<Message>::ArenaMessage() {
+        if (GetArenaMode() == ArenaMode::ON) {
+            arena_ = std::make_unique<google::protobuf::Arena>(GetArenaOptions());
+            message_ = google::protobuf::Arena::CreateMessage<Message>(arena_.get());
+        } else {
+            heap_message_ = std::make_unique<Message>();
+            message_ = heap_message_.get();
+        }
+    }
+
+    template <typename Message>
+    Message& ArenaMessage<Message>::operator*() const {
+        return *message_;
+    }
+
+    template <typename Message>
+    Message* ArenaMessage<Message>::operator->() const {
+        return message_;
+    }
+}  // namespace memory
@@ -0,0 +1,350 @@
+#include <algorithm>
+#include <set>
+#include <stdexcept>
+
+#include "catalogue_snapshot.h"
+
+namespace transport_catalogue::snapshot {
+    namespace {
+        // Заменяет разделяемую таблицу её копией, которую можно менять
+        template <typename Map>
+        std::shared_ptr<Map> Detach(std::shared_ptr<const Map>& map) {
+            auto copy = std::make_shared<Map>(*map);
+            map = copy;
+            return copy;
+        }
+
+        void InsertSorted(std::vector<std::string>& names, std::string_view name) {
+            const auto found_name = std::lower_bound(names.begin(), names.end(), name);
+            if (found_name == names.end() || *found_name != name) {
+                names.emplace(found_name, name);
+            }
+        }
+
+        void EraseSorted(std::vector<std::string>& names, std::string_view name) {
+            const auto found_name = std::lower_bound(names.begin(), names.end(), name);
+            if (found_name != names.end() && *found_name == name) {
+                names.erase(found_name);
+            }
+        }
+    }
+
+    //---------- CatalogueSnapshot ----------
+
+    CatalogueSnapshot::CatalogueSnapshot(std::shared_ptr<const TransportCatalogue> base, uint64_t version)
+        : base_(std::move(base))
+        , stops_(std::make_shared<const StopMap>())
+        , distances_(std::make_shared<const DistanceMap>())
+        , buses_(std::make_shared<const BusMap>())
+        , buses_at_stops_(std::make_shared<const BusesAtStopMap>())
+        , version_(version) {
+    }
+
+    uint64_t CatalogueSnapshot::GetVersion() const {
+        return version_;
+    }
+
+    std::optional<geo::Coordinates> CatalogueSnapshot::FindStopCoordinates(std::string_view stop_name) const {
+        if (const auto found_stop = stops_->find(stop_name); found_stop != stops_->end()) {
+            return found_stop->second;
+        }
+        const domain::StopId stop_id = base_->FindStopId(stop_name);
+        if (stop_id == domain::NO_ID) {
+            return std::nullopt;
+        }
+        return base_->GetStop(stop_id).coordinates;
+    }
+
+    std::optional<BusStat> CatalogueSnapshot::FindBusStat(std::string_view bus_name) const {
+        if (const auto found_bus = buses_->find(bus_name); found_bus != buses_->end()) {
+            return found_bus->second.stat;
+        }
+        const domain::Bus* bus = base_->FindRoute(bus_name);
+        if (!bus) {
+            return std::nullopt;
+        }
+        return BusStat{bus->stops_on_route, bus->unique_stops, bus->route_length, bus->curvature};
+    }
+
+    std::optional<std::vector<std::string_view>> CatalogueSnapshot::FindBusesAtStop(std::string_view stop_name) const {
+        if (const auto found_stop = buses_at_stops_->find(stop_name); found_stop != buses_at_stops_->end()) {
+            return std::vector<std::string_view>{found_stop->second.begin(), found_stop->second.end()};
+        }
+        const domain::StopId stop_id = base_->FindStopId(stop_name);
+        if (stop_id == domain::NO_ID) {
+            return stops_->count(stop_name) ? std::make_optional<std::vector<std::string_view>>() : std::nullopt;
+        }
+        std::vector<std::string_view> result;
+        for (const domain::BusId bus_id : base_->GetBusesAtStop(stop_id)) {
+            result.push_back(base_->GetBus(bus_id).number);
+        }
+        return result;
+    }
+
+    std::optional<int> CatalogueSnapshot::FindDistance(std::string_view from_stop, std::string_view to_stop) const {
+        const auto record = FindDistanceRecord(from_stop, to_stop);
+        return record ? std::make_optional(record->distance) : std::nullopt;
+    }
+
+    size_t CatalogueSnapshot::GetOverlaySize() const {
+        size_t result = stops_->size() + buses_->size();
+        for (const auto& [from_stop, distances] : *distances_) {
+            result += distances.size();
+        }
+        return result;
+    }
+
+    std::unique_ptr<CatalogueSnapshot> CatalogueSnapshot::WithChanges(const Changes& changes) const {
+        auto result = std::make_unique<CatalogueSnapshot>(*this);
+        result->version_ = version_ + 1;
+        if (changes.stops.empty() && changes.distances.empty() && changes.buses.empty()) {
+            return result;
+        }
+
+        // Таблицы result меняются через эти копии, поэтому поиск по result видит уже применённые изменения
+        const auto stops = changes.stops.empty() ? nullptr : Detach(result->stops_);
+        const auto distances = changes.distances.empty() ? nullptr : Detach(result->distances_);
+        const auto buses = Detach(result->buses_);
+        const auto buses_at_stops = Detach(result->buses_at_stops_);
+        const auto get_buses_at_stop = [&result, &buses_at_stops](std::string_view stop_name) -> std::vector<std::string>& {
+            auto found_stop = buses_at_stops->find(stop_name);
+            if (found_stop == buses_at_stops->end()) {
+                const auto buses_at_stop = result->FindBusesAtStop(stop_name);
+                found_stop = buses_at_stops->emplace(std::string{stop_name},
+                                                     std::vector<std::string>{buses_at_stop->begin(),
+                                                                              buses_at_stop->end()}).first;
+            }
+            return found_stop->second;
+        };
+        const auto is_unknown = [&result](std::string_view stop_name) {
+            return !result->FindStopCoordinates(stop_name);
+        };
+
+        // Остановки, у которых изменились координаты или расстояния: их маршруты нужно пересчитать
+        std::set<std::string, std::less<>> touched_stops;
+        for (const auto& [name, coordinates] : changes.stops) {
+            if (is_unknown(name)) {
+                buses_at_stops->emplace(std::string{name}, std::vector<std::string>{});
+            }
+            stops->insert_or_assign(std::string{name}, coordinates);
+            touched_stops.emplace(name);
+        }
+
+        for (const auto& [from_stop, to_stop, distance] : changes.distances) {
+            if (is_unknown(from_stop) || is_unknown(to_stop)) {
+                throw std::out_of_range("Unknown stop in road distances");
+            }
+            (*distances)[std::string{from_stop}].insert_or_assign(std::string{to_stop}, DistanceRecord{distance, true});
+            const auto reverse = result->FindDistanceRecord(to_stop, from_stop);
+            if (!reverse || !reverse->is_explicit) {
+                (*distances)[std::string{to_stop}].insert_or_assign(std::string{from_stop},
+                                                                    DistanceRecord{distance, false});
+            }
+            touched_stops.emplace(from_stop);
+            touched_stops.emplace(to_stop);
+        }
+
+        std::set<std::string, std::less<>> changed_buses;
+        for (const auto& bus : changes.buses) {
+            if (std::any_of(bus.stops.begin(), bus.stops.end(), is_unknown)) {
+                throw std::out_of_range("Unknown stop in bus " + std::string(bus.number));
+            }
+            if (const auto old_stops = result->FindBusStops(bus.number)) {
+                for (const std::string_view stop : *old_stops) {
+                    EraseSorted(get_buses_at_stop(stop), bus.number);
+                }
+            }
+            buses->insert_or_assign(std::string{bus.number},
+                                    BusRecord{{bus.stops.begin(), bus.stops.end()}, bus.is_roundtrip, {}});
+            for (const std::string_view stop : bus.stops) {
+                InsertSorted(get_buses_at_stop(stop), bus.number);
+            }
+            changed_buses.emplace(bus.number);
+        }
+        for (const auto& stop : touched_stops) {
+            const auto buses_at_stop = result->FindBusesAtStop(stop);
+            changed_buses.insert(buses_at_stop->begin(), buses_at_stop->end());
+        }
+
+        for (const auto& bus_name : changed_buses) {
+            auto found_bus = buses->find(bus_name);
+            if (found_bus == buses->end()) {
+                const domain::Bus& base_bus = *base_->FindRoute(bus_name);
+                BusRecord record;
+                record.is_roundtrip = base_bus.is_roundtrip;
+                for (const domain::StopId stop_id : base_bus.stops) {
+                    record.stops.emplace_back(base_->GetStop(stop_id).name);
+                }
+                found_bus = buses->emplace(bus_name, std::move(record)).first;
+            }
+            found_bus->second.stat = result->ComputeBusStat(*result->FindBusStops(bus_name),
+                                                             found_bus->second.is_roundtrip);
+        }
+        return result;
+    }
+
+    std::unique_ptr<CatalogueSnapshot> CatalogueSnapshot::Compact() const {
+        Changes base;
+        for (const domain::Stop& stop : base_->GetStops()) {
+            base.stops.push_back({stop.name, *FindStopCoordinates(stop.name)});
+        }
+        for (const auto& [name, coordinates] : *stops_) {
+            if (base_->FindStopId(name) == domain::NO_ID) {
+                base.stops.push_back({name, coordinates});
+            }
+        }
+
+        // Достаточно явно заданных расстояний: обратные направления AddBase восстановит сам.
+        // Явное расстояние базового справочника может быть заменено только явным же из слоя изменений
+        for (domain::StopId from_stop = 0; from_stop < base_->GetStops().size(); ++from_stop) {
+            const std::string_view from_name = base_->GetStop(from_stop).name;
+            const auto found_from = distances_->find(from_name);
+            for (const auto& [to_stop, distance, is_explicit] : base_->GetRoadDistances(from_stop)) {
+                const std::string_view to_name = base_->GetStop(to_stop).name;
+                if (is_explicit && (found_from == distances_->end() || !found_from->second.count(to_name))) {
+                    base.distances.push_back({from_name, to_name, distance});
+                }
+            }
+        }
+        for (const auto& [from_name, distances] : *distances_) {
+            for (const auto& [to_name, record] : distances) {
+                if (record.is_explicit) {
+                    base.distances.push_back({from_name, to_name, record.distance});
+                }
+            }
+        }
+
+        for (const domain::Bus& bus : base_->GetBuses()) {
+            if (!buses_->count(bus.number)) {
+                base.buses.push_back({bus.number, *FindBusStops(bus.number), bus.is_roundtrip, std::nullopt});
+            }
+        }
+        for (const auto& [number, record] : *buses_) {
+            base.buses.push_back({number, {record.stops.begin(), record.stops.end()}, record.is_roundtrip, std::nullopt});
+        }
+
+        auto catalogue = std::make_shared<TransportCatalogue>();
+        catalogue->AddBase(base);
+        return std::make_unique<CatalogueSnapshot>(std::move(catalogue), version_);
+    }
+
+    std::shared_ptr<const TransportCatalogue> CatalogueSnapshot::ToCatalogue() const {
+        if (GetOverlaySize() == 0) {
+            return base_;
+        }
+        return Compact()->base_;
+    }
+
+    std::optional<CatalogueSnapshot::DistanceRecord> CatalogueSnapshot::FindDistanceRecord(std::string_view from_stop,
+                                                                                          std::string_view to_stop) const {
+        if (const auto found_from = distances_->find(from_stop); found_from != distances_->end()) {
+            if (const auto found_to = found_from->second.find(to_stop); found_to != found_from->second.end()) {
+                return found_to->second;
+            }
+        }
+        const domain::StopId from_id = base_->FindStopId(from_stop);
+        const domain::StopId to_id = base_->FindStopId(to_stop);
+        if (from_id == domain::NO_ID || to_id == domain::NO_ID) {
+            return std::nullopt;
+        }
+        const auto* road_distance = base_->FindRoadDistance(from_id, to_id);
+        if (!road_distance) {
+            return std::nullopt;
+        }
+        return DistanceRecord{road_distance->distance, road_distance->is_explicit};
+    }
+
+    std::optional<std::vector<std::string_view>> CatalogueSnapshot::FindBusStops(std::string_view bus_name) const {
+        if (const auto found_bus = buses_->find(bus_name); found_bus != buses_->end()) {
+            return std::vector<std::string_view>{found_bus->second.stops.begin(), found_bus->second.stops.end()};
+        }
+        const domain::Bus* bus = base_->FindRoute(bus_name);
+        if (!bus) {
+            return std::nullopt;
+        }
+        std::vector<std::string_view> result;
+        result.reserve(bus->stops.size());
+        for (const domain::StopId stop_id : bus->stops) {
+            result.push_back(base_->GetStop(stop_id).name);
+        }
+        return result;
+    }
+
+    BusStat CatalogueSnapshot::ComputeBusStat(const std::vector<std::string_view>& stops, bool is_roundtrip) const {
+        std::vector<std::string_view> unique_stops = stops;
+        std::sort(unique_stops.begin(), unique_stops.end());
+        double geographic_distance = 0;
+        int route_length = 0;
+        const size_t route_size = domain::GetRouteSize(stops.size(), is_roundtrip);
+        for (size_t i = 1; i < route_size; ++i) {
+            const std::string_view from_stop = stops[domain::GetStoredStopIndex(i - 1, stops.size())];
+            const std::string_view to_stop = stops[domain::GetStoredStopIndex(i, stops.size())];
+            geographic_distance += ComputeDistance(*FindStopCoordinates(from_stop), *FindStopCoordinates(to_stop));
+            const auto distance = FindDistance(from_stop, to_stop);
+            if (!distance) {
+                throw std::out_of_range("No distance between stops");
+            }
+            route_length += *distance;
+        }
+        BusStat result;
+        result.stops_on_route = static_cast<int>(route_size);
+        result.unique_stops = static_cast<int>(std::unique(unique_stops.begin(), unique_stops.end())
+                                               - unique_stops.begin());
+        result.route_length = route_length;
+        result.curvature = route_length / geographic_distance;
+        return result;
+    }
+
+    //---------- CatalogueStore ----------
+
+    CatalogueStore::ReadView::ReadView(memory::EpochDomain::ReadGuard guard, const CatalogueSnapshot* snapshot)
+        : guard_(std::move(guard))
+        , snapshot_(snapshot) {
+    }
+
+    const CatalogueSnapshot& CatalogueStore::ReadView::operator*() const {
+        return *snapshot_;
+    }
+
+    const CatalogueSnapshot* CatalogueStore::ReadView::operator->() const {
+        return snapshot_;
+    }
+
+    CatalogueStore::CatalogueStore(std::shared_ptr<const TransportCatalogue> catalogue, size_t compaction_threshold)
+        : current_(new CatalogueSnapshot(std::move(catalogue)))
+        , compaction_threshold_(compaction_threshold) {
+    }
+
+    CatalogueStore::~CatalogueStore() {
+        delete current_.load();
+    }
+
+    // Эпоха объявляется до чтения указателя: версия, заменённая после этого, не освободится, пока жив ReadView
+    CatalogueStore::ReadView CatalogueStore::Read() const {
+        memory::EpochDomain::ReadGuard guard = epochs_.Enter();
+        return ReadView{std::move(guard), current_.load()};
+    }
+
+    void CatalogueStore::Update(const CatalogueSnapshot::Changes& changes) {
+        std::lock_guard guard(writer_mutex_);
+        // Версии заменяет только писатель под writer_mutex_, поэтому текущую он читает без объявления эпохи
+        std::unique_ptr<const CatalogueSnapshot> next = current_.load()->WithChanges(changes);
+        if (next->GetOverlaySize() > compaction_threshold_) {
+            next = next->Compact();
+        }
+        const CatalogueSnapshot* previous = current_.exchange(next.release());
+        retired_.emplace_back(epochs_.Advance(), previous);
+        Reclaim();
+    }
+
+    size_t CatalogueStore::GetRetiredCount() const {
+        std::lock_guard guard(writer_mutex_);
+        return retired_.size();
+    }
+
+    void CatalogueStore::Reclaim() {
+        retired_.erase(std::remove_if(retired_.begin(), retired_.end(), [this](const auto& retired) {
+            return epochs_.IsQuiescent(retired.first);
+        }), retired_.end());
+    }
+}  // namespace transport_catalogue::snapshot
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "epoch.h"
+#include "geo.h"
+#include "transport_catalogue.h"
+
+namespace transport_catalogue::snapshot {
+
+    struct BusStat {
+        int stops_on_route = 0;
+        int unique_stops = 0;
+        int route_length = 0;
+        double curvature = 0.;
+    };
+
+    // Неизменяемая версия справочника. Состоит из общего для многих версий базового справочника и небольшого
+    // слоя изменений поверх него. Новая версия строится из старой: таблицы слоя, которых не коснулись
+    // изменения, и базовый справочник не копируются, а разделяются между версиями
+    class CatalogueSnapshot {
+    public:
+        using TransportCatalogue = transport_catalogue::TransportCatalogue;
+        using Changes = TransportCatalogue::BaseInput<std::string_view>;
+
+        explicit CatalogueSnapshot(std::shared_ptr<const TransportCatalogue> base, uint64_t version = 0);
+
+        [[nodiscard]] uint64_t GetVersion() const;
+        [[nodiscard]] std::optional<geo::Coordinates> FindStopCoordinates(std::string_view stop_name) const;
+        [[nodiscard]] std::optional<BusStat> FindBusStat(std::string_view bus_name) const;
+        // Автобусы, проходящие через остановку, по возрастанию названий. nullopt, если остановки нет
+        [[nodiscard]] std::optional<std::vector<std::string_view>> FindBusesAtStop(std::string_view stop_name) const;
+        // Расстояние по дорогам между соседними остановками. Если задано только обратное - берётся оно
+        [[nodiscard]] std::optional<int> FindDistance(std::string_view from_stop, std::string_view to_stop) const;
+        // Число записей в слое изменений
+        [[nodiscard]] size_t GetOverlaySize() const;
+
+        // Версия с применёнными изменениями: сначала остановки, затем расстояния, затем маршруты.
+        // Параметры маршрутов, затронутых изменениями, пересчитываются. Бросает std::out_of_range, если изменения
+        // ссылаются на неизвестную остановку или у маршрута не хватает расстояния; текущая версия не меняется
+        [[nodiscard]] std::unique_ptr<CatalogueSnapshot> WithChanges(const Changes& changes) const;
+        // Та же версия справочника, собранная в новый базовый справочник с пустым слоем изменений
+        [[nodiscard]] std::unique_ptr<CatalogueSnapshot> Compact() const;
+        // Справочник с содержимым этой версии: базовый, если слой изменений пуст, иначе собранный заново
+        [[nodiscard]] std::shared_ptr<const TransportCatalogue> ToCatalogue() const;
+
+    private:
+        struct DistanceRecord {
+            int distance = 0;
+            bool is_explicit = false;
+        };
+
+        struct BusRecord {
+            // У некольцевого маршрута - только в прямом направлении
+            std::vector<std::string> stops;
+            bool is_roundtrip = false;
+            BusStat stat;
+        };
+
+        using StopMap = std::map<std::string, geo::Coordinates, std::less<>>;
+        using DistanceMap = std::map<std::string, std::map<std::string, DistanceRecord, std::less<>>, std::less<>>;
+        using BusMap = std::map<std::string, BusRecord, std::less<>>;
+        using BusesAtStopMap = std::map<std::string, std::vector<std::string>, std::less<>>;
+
+        [[nodiscard]] std::optional<DistanceRecord> FindDistanceRecord(std::string_view from_stop,
+                                                                       std::string_view to_stop) const;
+        [[nodiscard]] std::optional<std::vector<std::string_view>> FindBusStops(std::string_view bus_name) const;
+        // Параметры маршрута по хранимым остановкам: у некольцевого - только в прямом направлении
+        [[nodiscard]] BusStat ComputeBusStat(const std::vector<std::string_view>& stops, bool is_roundtrip) const;
+
+        std::shared_ptr<const TransportCatalogue> base_;
+        std::shared_ptr<const StopMap> stops_;
+        std::shared_ptr<const DistanceMap> distances_;
+        std::shared_ptr<const BusMap> buses_;
+        // Полные списки автобусов остановок, через которые прошли изменённые маршруты
+        std::shared_ptr<const BusesAtStopMap> buses_at_stops_;
+        uint64_t version_;
+    };
+
+    // Текущая версия справочника, доступная читателям без блокировок (RCU). Писатель строит новую версию,
+    // атомарно публикует её и освобождает старые версии, когда их перестают читать
+    class CatalogueStore {
+    public:
+        // Число записей слоя изменений, после которого версия собирается в новый базовый справочник
+        static constexpr size_t DEFAULT_COMPACTION_THRESHOLD = 4096;
+
+        // Версия справочника, которая не освобождается, пока объект жив
+        class ReadView {
+        public:
+            const CatalogueSnapshot& operator*() const;
+            const CatalogueSnapshot* operator->() const;
+
+        private:
+            friend class CatalogueStore;
+            ReadView(memory::EpochDomain::ReadGuard guard, const CatalogueSnapshot* snapshot);
+
+            memory::EpochDomain::ReadGuard guard_;
+            const CatalogueSnapshot* snapshot_;
+        };
+
+        explicit CatalogueStore(std::shared_ptr<const TransportCatalogue> catalogue,
+                                size_t compaction_threshold = DEFAULT_COMPACTION_THRESHOLD);
+        CatalogueStore(const CatalogueStore&) = delete;
+        CatalogueStore& operator=(const CatalogueStore&) = delete;
+        // Читателей к моменту разрушения остаться не должно
+        ~CatalogueStore();
+
+        [[nodiscard]] ReadView Read() const;
+        // Публикует версию с изменениями. Писатели выполняются по одному, читателей они не ждут
+        void Update(const CatalogueSnapshot::Changes& changes);
+        // Число заменённых версий, которые ещё могут читаться
+        [[nodiscard]] size_t GetRetiredCount() const;
+
+    private:
+        void Reclaim();
+
+        mutable memory::EpochDomain epochs_;
+        std::atomic<const CatalogueSnapshot*> current_;
+        size_t compaction_threshold_;
+        mutable std::mutex writer_mutex_;
+        std::vector<std::pair<uint64_t, std::unique_ptr<const CatalogueSnapshot>>> retired_;
+    };
+}  // namespace transport_catalogue::snapshot
@@ -0,0 +1,69 @@
+#include <algorithm>
+#include <iterator>
+
+#include "direct_buses.h"
+
+namespace transport_catalogue::connection {
+
+    DirectBusesIndex::DirectBusesIndex(const TransportCatalogue& catalogue)
+        : buses_(catalogue.GetBusIdsByName()) {
+        words_per_stop_ = (buses_.size() + WORD_BITS - 1) / WORD_BITS;
+        stop_buses_.assign(catalogue.GetStops().size() * words_per_stop_, 0);
+        is_roundtrip_.reserve(buses_.size());
+        offsets_.reserve(buses_.size() + 1);
+        offsets_.push_back(0);
+        for (size_t bit = 0; bit < buses_.size(); ++bit) {
+            const domain::Bus& bus = catalogue.GetBus(buses_[bit]);
+            is_roundtrip_.push_back(bus.is_roundtrip);
+            const size_t first_position = positions_.size();
+            for (uint32_t position = 0; position < bus.stops.size(); ++position) {
+                const domain::StopId stop = bus.stops[position];
+                stop_buses_[stop * words_per_stop_ + bit / WORD_BITS] |= Word{1} << (bit % WORD_BITS);
+                positions_.push_back({stop, position});
+            }
+            std::sort(positions_.begin() + first_position, positions_.end(),
+                      [](const StopPosition& lhs, const StopPosition& rhs) {
+                return lhs.stop < rhs.stop || (lhs.stop == rhs.stop && lhs.position < rhs.position);
+            });
+            offsets_.push_back(positions_.size());
+        }
+    }
+
+    // Позиции остановки на маршруте отсортированы, поэтому поездка в нужную сторону есть, если первая позиция
+    // одной остановки меньше последней позиции другой
+    std::vector<DirectBus> DirectBusesIndex::Find(domain::StopId from_stop, domain::StopId to_stop) const {
+        std::vector<DirectBus> result;
+        const size_t stop_count = words_per_stop_ == 0 ? 0 : stop_buses_.size() / words_per_stop_;
+        if (from_stop >= stop_count || to_stop >= stop_count) {
+            return result;
+        }
+        const Word* from_buses = stop_buses_.data() + from_stop * words_per_stop_;
+        const Word* to_buses = stop_buses_.data() + to_stop * words_per_stop_;
+        for (size_t word = 0; word < words_per_stop_; ++word) {
+            for (Word common = from_buses[word] & to_buses[word]; common != 0; common &= common - 1) {
+                const size_t bit = word * WORD_BITS + __builtin_ctzll(common);
+                const PositionRange from_positions = FindPositions(bit, from_stop);
+                const PositionRange to_positions = FindPositions(bit, to_stop);
+                if (from_positions.begin()->position < std::prev(to_positions.end())->position) {
+                    result.push_back({buses_[bit], Direction::FORWARD});
+                }
+                if (!is_roundtrip_[bit] && to_positions.begin()->position < std::prev(from_positions.end())->position) {
+                    result.push_back({buses_[bit], Direction::BACKWARD});
+                }
+            }
+        }
+        return result;
+    }
+
+    DirectBusesIndex::PositionRange DirectBusesIndex::FindPositions(size_t bit, domain::StopId stop) const {
+        const auto begin = positions_.begin() + offsets_[bit];
+        const auto end = positions_.begin() + offsets_[bit + 1];
+        const auto first = std::lower_bound(begin, end, stop, [](const StopPosition& lhs, domain::StopId rhs) {
+            return lhs.stop < rhs;
+        });
+        const auto last = std::upper_bound(first, end, stop, [](domain::StopId lhs, const StopPosition& rhs) {
+            return lhs < rhs.stop;
+        });
+        return {first, last};
+    }
+}  // namespace transport_catalogue::connection
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "domain.h"
+#include "ranges.h"
+#include "transport_catalogue.h"
+
+namespace transport_catalogue::connection {
+
+    // Направление поездки: по порядку остановок маршрута или, у некольцевого маршрута, в обратную сторону
+    enum class Direction {
+        FORWARD,
+        BACKWARD
+    };
+
+    struct DirectBus {
+        domain::BusId bus;
+        Direction direction;
+    };
+
+    // Статический индекс автобусов, идущих от одной остановки до другой без пересадок. У каждой остановки -
+    // битовое множество проходящих через неё автобусов (бит - позиция автобуса в порядке названий),
+    // у каждого автобуса - позиции остановок на хранимом маршруте. Кандидаты находятся пересечением множеств
+    // двух остановок по 64 бита, направление проверяется по позициям. Множества занимают
+    // число остановок * число автобусов / 8 байт
+    class DirectBusesIndex {
+    public:
+        DirectBusesIndex() = default;
+        explicit DirectBusesIndex(const TransportCatalogue& catalogue);
+
+        // Автобусы, на которых можно доехать от from_stop до to_stop без пересадок, по возрастанию названий.
+        // Некольцевой маршрут, проходящий остановки в обоих порядках, попадает в ответ дважды
+        [[nodiscard]] std::vector<DirectBus> Find(domain::StopId from_stop, domain::StopId to_stop) const;
+
+    private:
+        using Word = uint64_t;
+        static const size_t WORD_BITS = 64;
+
+        struct StopPosition {
+            domain::StopId stop;
+            uint32_t position;
+        };
+        using PositionRange = ranges::Range<std::vector<StopPosition>::const_iterator>;
+
+        // Позиции остановки на маршруте автобуса с битом bit, по возрастанию
+        [[nodiscard]] PositionRange FindPositions(size_t bit, domain::StopId stop) const;
+
+        size_t words_per_stop_ = 0;
+        // Множество автобусов остановки stop_id - слова [stop_id * words_per_stop_, (stop_id + 1) * words_per_stop_)
+        std::vector<Word> stop_buses_;
+        // Номер автобуса и кольцевой ли маршрут, по номеру бита
+        std::vector<domain::BusId> buses_;
+        std::vector<bool> is_roundtrip_;
+        // Позиции остановок маршрутов подряд, по (остановка, позиция); автобус с битом i - [offsets_[i], offsets_[i + 1])
+        std::vector<StopPosition> positions_;
+        std::vector<size_t> offsets_;
+    };
+}  // namespace transport_catalogue::connection
@@ -1,7 +1,48 @@
+#include <algorithm>
+
 #include "domain.h"
 
 namespace transport_catalogue::domain {
+    size_t GetRouteSize(size_t stop_count, bool is_roundtrip) {
+        return is_roundtrip || stop_count == 0 ? stop_count : stop_count * 2 - 1;
+    }
+
+    size_t GetStoredStopIndex(size_t index, size_t stop_count) {
+        return index < stop_count ? index : stop_count * 2 - 2 - index;
+    }
+
     bool Bus::operator==(const Bus& other) const {
         return this->number == other.number;
     }
-}
\ No newline at end of file
+
+    size_t Bus::GetRouteSize() const {
+        return domain::GetRouteSize(stops.size(), is_roundtrip);
+    }
+
+    StopId Bus::GetRouteStop(size_t index) const {
+        return stops[GetStoredStopIndex(index, stops.size())];
+    }
+
+    std::string_view StringArena::Intern(std::string_view str) {
+        const auto found_string = strings_.find(str);
+        if (found_string != strings_.end()) {
+            return *found_string;
+        }
+
+        char* data;
+        if (str.size() > BLOCK_SIZE / 4) {
+            // Длинная строка получает собственный блок, чтобы не оставлять пустые хвосты в общих
+            long_strings_.push_back(std::make_unique<char[]>(str.size()));
+            data = long_strings_.back().get();
+        } else {
+            if (blocks_.empty() || block_free_ < str.size()) {
+                blocks_.push_back(std::make_unique<char[]>(BLOCK_SIZE));
+                block_free_ = BLOCK_SIZE;
+            }
+            data = blocks_.back().get() + (BLOCK_SIZE - block_free_);
+            block_free_ -= str.size();
+        }
+        std::copy(str.begin(), str.end(), data);
+        return *strings_.emplace(data, str.size()).first;
+    }
+}
@@ -1,34 +1,71 @@
 #pragma once
 
+#include <cstdint>
+#include <limits>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
 #include "geo.h"
 
 namespace transport_catalogue::domain {
 
+    // Плотные номера остановок и автобусов: порядковый номер добавления в справочник
+    using StopId = uint32_t;
+    using BusId = uint32_t;
+
+    inline constexpr uint32_t NO_ID = std::numeric_limits<uint32_t>::max();
+
+    // Некольцевой маршрут хранится в одну сторону: A, B, C. Полный маршрут A, B, C, B, A получается
+    // проходом по хранимым остановкам туда и обратно. Число остановок полного маршрута из stop_count хранимых
+    [[nodiscard]] size_t GetRouteSize(size_t stop_count, bool is_roundtrip);
+    // Позиция среди stop_count хранимых остановок для остановки полного маршрута с номером index
+    [[nodiscard]] size_t GetStoredStopIndex(size_t index, size_t stop_count);
+
     struct Stop {
-        std::string name;
+        std::string_view name;
         geo::Coordinates coordinates;
+        StopId id = NO_ID;
     };
 
     struct Bus {
         bool operator==(const Bus& other) const;
 
-        std::string number;
+        // Число остановок и остановка полного маршрута, с обратным направлением некольцевого
+        [[nodiscard]] size_t GetRouteSize() const;
+        [[nodiscard]] StopId GetRouteStop(size_t index) const;
+
+        std::string_view number;
         int stops_on_route = 0;
         int unique_stops = 0;
         int route_length = 0;
         double curvature = 0.;
         bool is_roundtrip = false;
+        BusId id = NO_ID;
+        // Остановки маршрута в порядке следования, у некольцевого - только в прямом направлении
+        std::vector<StopId> stops;
     };
 
-    template<typename First, typename Second>
-    class PairPtrHash {
+    // Хранилище названий: каждая строка копируется один раз в большие блоки памяти
+    // и живёт, пока живёт хранилище. Повторное добавление возвращает уже сохранённую строку
+    class StringArena {
     public:
-        uint64_t operator()(const std::pair<First, Second>& pair_pointers) const {
-            return hasher_(pair_pointers.first) + 37 * hasher_(pair_pointers.second);
-        }
+        StringArena() = default;
+        StringArena(const StringArena&) = delete;
+        StringArena& operator=(const StringArena&) = delete;
+        StringArena(StringArena&&) = default;
+        StringArena& operator=(StringArena&&) = default;
+
+        std::string_view Intern(std::string_view str);
 
     private:
-        std::hash<const void*> hasher_;
+        static const size_t BLOCK_SIZE = 4096;
+
+        std::vector<std::unique_ptr<char[]>> blocks_;
+        std::vector<std::unique_ptr<char[]>> long_strings_;
+        size_t block_free_ = 0;
+        std::unordered_set<std::string_view> strings_;
     };
-}
\ No newline at end of file
+}
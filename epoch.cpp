@@ -0,0 +1,52 @@
+#include <functional>
+#include <thread>
+
+#include "epoch.h"
+
+namespace memory {
+    EpochDomain::ReadGuard::ReadGuard(std::atomic<uint64_t>* slot) noexcept
+        : slot_(slot) {
+    }
+
+    EpochDomain::ReadGuard::ReadGuard(ReadGuard&& other) noexcept
+        : slot_(other.slot_) {
+        other.slot_ = nullptr;
+    }
+
+    EpochDomain::ReadGuard::~ReadGuard() {
+        if (slot_) {
+            slot_->store(FREE);
+        }
+    }
+
+    // Эпоха читается до захвата ячейки и могла устареть к моменту захвата. Это безопасно: объявленная эпоха
+    // не позже той, в которой читатель получит указатель, поэтому писатель будет ждать его не меньше нужного
+    EpochDomain::ReadGuard EpochDomain::Enter() {
+        const size_t first_slot = std::hash<std::thread::id>{}(std::this_thread::get_id()) % MAX_READERS;
+        while (true) {
+            for (size_t i = 0; i < MAX_READERS; ++i) {
+                std::atomic<uint64_t>& slot = slots_[(first_slot + i) % MAX_READERS].epoch;
+                uint64_t expected = FREE;
+                if (slot.load(std::memory_order_relaxed) == FREE
+                    && slot.compare_exchange_strong(expected, epoch_.load())) {
+                    return ReadGuard{&slot};
+                }
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    uint64_t EpochDomain::Advance() {
+        return epoch_.fetch_add(1);
+    }
+
+    bool EpochDomain::IsQuiescent(uint64_t epoch) const {
+        for (const Slot& slot : slots_) {
+            const uint64_t reader_epoch = slot.epoch.load();
+            if (reader_epoch != FREE && reader_epoch <= epoch) {
+                return false;
+            }
+        }
+        return true;
+    }
+}  // namespace memory
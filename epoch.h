@@ -0,0 +1,53 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace memory {
+    // Эпохи для отложенного освобождения общих данных (epoch-based reclamation).
+    // Читатель перед обращением к данным объявляет текущую эпоху в свободной ячейке и снимает объявление
+    // по окончании, блокировок при этом не берётся. Писатель, заменив указатель, вызывает Advance и хранит
+    // старые данные, пока IsQuiescent не подтвердит, что читателей из их эпохи не осталось
+    class EpochDomain {
+    public:
+        // Объявление читателя. Пока объект жив, данные, доступные в момент его создания, не освобождаются
+        class ReadGuard {
+        public:
+            ReadGuard(ReadGuard&& other) noexcept;
+            ReadGuard& operator=(ReadGuard&&) = delete;
+            ~ReadGuard();
+
+        private:
+            friend class EpochDomain;
+            explicit ReadGuard(std::atomic<uint64_t>* slot) noexcept;
+
+            std::atomic<uint64_t>* slot_;
+        };
+
+        // Одновременно читать могут не больше MAX_READERS читателей, остальные ждут освобождения ячейки
+        static constexpr size_t MAX_READERS = 256;
+
+        EpochDomain() = default;
+        EpochDomain(const EpochDomain&) = delete;
+        EpochDomain& operator=(const EpochDomain&) = delete;
+
+        [[nodiscard]] ReadGuard Enter();
+        // Начинает новую эпоху. Возвращает эпоху, в которой были заменены данные, опубликованные до вызова
+        uint64_t Advance();
+        // true, если ни один читатель не объявил эпоху epoch или более раннюю
+        [[nodiscard]] bool IsQuiescent(uint64_t epoch) const;
+
+    private:
+        static constexpr uint64_t FREE = 0;
+
+        // Каждая ячейка на своей кэш-линии, чтобы читатели разных потоков не мешали друг другу
+        struct alignas(64) Slot {
+            std::atomic<uint64_t> epoch{FREE};
+        };
+
+        std::array<Slot, MAX_READERS> slots_;
+        std::atomic<uint64_t> epoch_{1};
+    };
+}  // namespace memory
@@ -1,5 +1,6 @@
 #define _USE_MATH_DEFINES
 
+#include <algorithm>
 #include <cmath>
 #include "geo.h"
 
@@ -8,9 +9,10 @@ namespace geo {
     double ComputeDistance(Coordinates from, Coordinates to) {
         using namespace std;
         const double dr = M_PI / 180.0;
-        return acos(sin(from.lat * dr) * sin(to.lat * dr)
-                    + cos(from.lat * dr) * cos(to.lat * dr) * cos(abs(from.lng - to.lng) * dr))
-                    * 6371000;
+        // Из-за округления косинус угла для близких точек может выйти чуть больше 1
+        const double angle_cos = sin(from.lat * dr) * sin(to.lat * dr)
+                                 + cos(from.lat * dr) * cos(to.lat * dr) * cos(abs(from.lng - to.lng) * dr);
+        return acos(clamp(angle_cos, -1., 1.)) * EARTH_RADIUS;
     }
 
 }  // namespace geo
\ No newline at end of file
@@ -7,6 +7,10 @@ namespace geo {
         double lng; // Долгота
     };
 
+    // Радиус Земли в метрах
+    const double EARTH_RADIUS = 6371000;
+
+    // Расстояние в метрах по поверхности Земли
     double ComputeDistance(Coordinates from, Coordinates to);
 
 }  // namespace geo
\ No newline at end of file
@@ -1,8 +1,10 @@
 #pragma once
 
 #include <cstdlib>
+#include <utility>
 #include <vector>
 
+#include "huge_pages.h"
 #include "ranges.h"
 
 namespace graph {
@@ -26,6 +28,7 @@ namespace graph {
     public:
         DirectedWeightedGraph() = default;
         explicit DirectedWeightedGraph(size_t vertex_count);
+        VertexId AddVertex();
         EdgeId AddEdge(const Edge<Weight>& edge);
 
         [[nodiscard]] size_t GetVertexCount() const;
@@ -38,11 +41,62 @@ namespace graph {
         std::vector<IncidenceList> incidence_lists_;
     };
 
+    // Неизменяемый граф в формате CSR: исходящие рёбра вершины v занимают позиции
+    // [GetIncidentBegin(v), GetIncidentEnd(v)) в непрерывных массивах целей, весов и номеров рёбер.
+    // Порядок рёбер внутри вершины совпадает с порядком их добавления в DirectedWeightedGraph
+    template <typename Weight>
+    class FrozenGraph {
+    private:
+        // Массивы графа обходятся при каждом поиске маршрута, поэтому выделяются через HugePageAllocator
+        template <typename T>
+        using Array = std::vector<T, memory::HugePageAllocator<T>>;
+        using EdgeIds = Array<EdgeId>;
+        using IncidentEdgesRange = ranges::Range<typename EdgeIds::const_iterator>;
+
+    public:
+        FrozenGraph() = default;
+        explicit FrozenGraph(size_t vertex_count);
+        explicit FrozenGraph(const DirectedWeightedGraph<Weight>& graph);
+        FrozenGraph(size_t vertex_count, std::vector<Edge<Weight>> edges);
+
+        [[nodiscard]] size_t GetVertexCount() const;
+        [[nodiscard]] size_t GetEdgeCount() const;
+        const Edge<Weight>& GetEdge(EdgeId edge_id) const;
+        [[nodiscard]] IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
+
+        [[nodiscard]] size_t GetIncidentBegin(VertexId vertex) const;
+        [[nodiscard]] size_t GetIncidentEnd(VertexId vertex) const;
+        [[nodiscard]] VertexId GetTarget(size_t position) const;
+        [[nodiscard]] Weight GetWeight(size_t position) const;
+        [[nodiscard]] EdgeId GetEdgeId(size_t position) const;
+
+    private:
+        void BuildIncidence();
+
+        Array<Edge<Weight>> edges_;
+        Array<size_t> offsets_;
+        Array<VertexId> targets_;
+        Array<Weight> weights_;
+        EdgeIds edge_ids_;
+    };
+
+    // Номера рёбер, оставшихся после удаления доминируемых параллельных рёбер: для каждой пары вершин (from, to)
+    // остаётся только ребро наименьшего веса, а при равных весах - добавленное раньше.
+    // Номера возвращаются по возрастанию, порядок оставшихся рёбер не меняется
+    template <typename Weight>
+    std::vector<EdgeId> FindDominantEdges(const DirectedWeightedGraph<Weight>& graph);
+
     template <typename Weight>
     DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count)
             : incidence_lists_(vertex_count) {
     }
 
+    template <typename Weight>
+    VertexId DirectedWeightedGraph<Weight>::AddVertex() {
+        incidence_lists_.emplace_back();
+        return incidence_lists_.size() - 1;
+    }
+
     template <typename Weight>
     EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight>& edge) {
         edges_.push_back(edge);
@@ -71,4 +125,126 @@ namespace graph {
     DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
         return ranges::AsRange(incidence_lists_.at(vertex));
     }
+
+    template <typename Weight>
+    std::vector<EdgeId> FindDominantEdges(const DirectedWeightedGraph<Weight>& graph) {
+        const size_t vertex_count = graph.GetVertexCount();
+        const EdgeId no_edge = graph.GetEdgeCount();
+        std::vector<EdgeId> best_edges(vertex_count, no_edge);
+        std::vector<bool> is_dominant(graph.GetEdgeCount(), false);
+
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+                EdgeId& best_edge = best_edges[graph.GetEdge(edge_id).to];
+                if (best_edge == no_edge || graph.GetEdge(edge_id).weight < graph.GetEdge(best_edge).weight) {
+                    best_edge = edge_id;
+                }
+            }
+            for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+                EdgeId& best_edge = best_edges[graph.GetEdge(edge_id).to];
+                if (best_edge != no_edge) {
+                    is_dominant[best_edge] = true;
+                    best_edge = no_edge;
+                }
+            }
+        }
+
+        std::vector<EdgeId> result;
+        for (EdgeId edge_id = 0; edge_id < is_dominant.size(); ++edge_id) {
+            if (is_dominant[edge_id]) {
+                result.push_back(edge_id);
+            }
+        }
+        return result;
+    }
+
+    template <typename Weight>
+    FrozenGraph<Weight>::FrozenGraph(size_t vertex_count)
+            : offsets_(vertex_count + 1, 0) {
+    }
+
+    template <typename Weight>
+    FrozenGraph<Weight>::FrozenGraph(const DirectedWeightedGraph<Weight>& graph)
+            : offsets_(graph.GetVertexCount() + 1, 0) {
+        const size_t edge_count = graph.GetEdgeCount();
+        edges_.reserve(edge_count);
+        for (EdgeId edge_id = 0; edge_id < edge_count; ++edge_id) {
+            edges_.push_back(graph.GetEdge(edge_id));
+        }
+        BuildIncidence();
+    }
+
+    template <typename Weight>
+    FrozenGraph<Weight>::FrozenGraph(size_t vertex_count, std::vector<Edge<Weight>> edges)
+            : edges_(edges.begin(), edges.end())
+            , offsets_(vertex_count + 1, 0) {
+        BuildIncidence();
+    }
+
+    template <typename Weight>
+    void FrozenGraph<Weight>::BuildIncidence() {
+        for (const auto& edge : edges_) {
+            ++offsets_[edge.from + 1];
+        }
+        for (size_t vertex = 1; vertex < offsets_.size(); ++vertex) {
+            offsets_[vertex] += offsets_[vertex - 1];
+        }
+
+        targets_.resize(edges_.size());
+        weights_.resize(edges_.size());
+        edge_ids_.resize(edges_.size());
+        std::vector<size_t> next_positions(offsets_.begin(), offsets_.end() - 1);
+        for (EdgeId edge_id = 0; edge_id < edges_.size(); ++edge_id) {
+            const auto& edge = edges_[edge_id];
+            const size_t position = next_positions[edge.from]++;
+            targets_[position] = edge.to;
+            weights_[position] = edge.weight;
+            edge_ids_[position] = edge_id;
+        }
+    }
+
+    template <typename Weight>
+    size_t FrozenGraph<Weight>::GetVertexCount() const {
+        return offsets_.empty() ? 0 : offsets_.size() - 1;
+    }
+
+    template <typename Weight>
+    size_t FrozenGraph<Weight>::GetEdgeCount() const {
+        return edges_.size();
+    }
+
+    template <typename Weight>
+    const Edge<Weight>& FrozenGraph<Weight>::GetEdge(EdgeId edge_id) const {
+        return edges_[edge_id];
+    }
+
+    template <typename Weight>
+    typename FrozenGraph<Weight>::IncidentEdgesRange FrozenGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
+        return {edge_ids_.begin() + offsets_[vertex], edge_ids_.begin() + offsets_[vertex + 1]};
+    }
+
+    template <typename Weight>
+    size_t FrozenGraph<Weight>::GetIncidentBegin(VertexId vertex) const {
+        return offsets_[vertex];
+    }
+
+    template <typename Weight>
+    size_t FrozenGraph<Weight>::GetIncidentEnd(VertexId vertex) const {
+        return offsets_[vertex + 1];
+    }
+
+    template <typename Weight>
+    VertexId FrozenGraph<Weight>::GetTarget(size_t position) const {
+        return targets_[position];
+    }
+
+    template <typename Weight>
+    Weight FrozenGraph<Weight>::GetWeight(size_t position) const {
+        return weights_[position];
+    }
+
+    template <typename Weight>
+    EdgeId FrozenGraph<Weight>::GetEdgeId(size_t position) const {
+        return edge_ids_[position];
+    }
 }  // namespace graph
\ No newline at end of file
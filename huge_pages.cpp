@@ -0,0 +1,159 @@
+#include <atomic>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <sys/mman.h>
+
+#include "huge_pages.h"
+
+namespace memory {
+    namespace {
+        enum class PageKind {
+            EXPLICIT,
+            TRANSPARENT,
+            REGULAR
+        };
+
+        std::atomic<HugePagesMode> huge_pages_mode{HugePagesMode::OFF};
+
+        std::mutex blocks_mutex;
+        std::unordered_map<void*, PageKind> blocks;
+        HugePagesStats stats;
+
+        size_t RoundUpToHugePage(size_t bytes) {
+            return (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+        }
+
+        void* MapExplicit(size_t length) {
+#ifdef MAP_HUGETLB
+            void* pointer = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+                                 -1, 0);
+            return pointer == MAP_FAILED ? nullptr : pointer;
+#else
+            return nullptr;
+#endif
+        }
+
+        // Отображает length байт, выровненных на HUGE_PAGE_SIZE: лишнее до и после выровненного блока освобождается
+        void* MapAligned(size_t length) {
+            void* pointer = mmap(nullptr, length + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+                                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (pointer == MAP_FAILED) {
+                return nullptr;
+            }
+            const auto address = reinterpret_cast<uintptr_t>(pointer);
+            const uintptr_t aligned = (address + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+            if (aligned != address) {
+                munmap(pointer, aligned - address);
+            }
+            const size_t tail = address + HUGE_PAGE_SIZE - aligned;
+            if (tail != 0) {
+                munmap(reinterpret_cast<void*>(aligned + length), tail);
+            }
+            return reinterpret_cast<void*>(aligned);
+        }
+
+        void AddBlock(void* pointer, PageKind kind, size_t bytes) {
+            std::lock_guard guard(blocks_mutex);
+            blocks.emplace(pointer, kind);
+            ++stats.blocks;
+            switch (kind) {
+                case PageKind::EXPLICIT:
+                    stats.explicit_bytes += bytes;
+                    break;
+                case PageKind::TRANSPARENT:
+                    stats.transparent_bytes += bytes;
+                    break;
+                case PageKind::REGULAR:
+                    stats.regular_bytes += bytes;
+                    break;
+            }
+        }
+
+        void RemoveBlock(void* pointer, size_t bytes) {
+            std::lock_guard guard(blocks_mutex);
+            const auto found_block = blocks.find(pointer);
+            if (found_block == blocks.end()) {
+                return;
+            }
+            switch (found_block->second) {
+                case PageKind::EXPLICIT:
+                    stats.explicit_bytes -= bytes;
+                    break;
+                case PageKind::TRANSPARENT:
+                    stats.transparent_bytes -= bytes;
+                    break;
+                case PageKind::REGULAR:
+                    stats.regular_bytes -= bytes;
+                    break;
+            }
+            blocks.erase(found_block);
+            --stats.blocks;
+        }
+    }
+
+    void SetHugePagesMode(HugePagesMode mode) {
+        huge_pages_mode = mode;
+    }
+
+    HugePagesMode GetHugePagesMode() {
+        return huge_pages_mode;
+    }
+
+    HugePagesStats GetHugePagesStats() {
+        std::lock_guard guard(blocks_mutex);
+        return stats;
+    }
+
+    std::optional<size_t> GetAnonHugePagesBytes() {
+        const std::string key = "AnonHugePages:";
+        std::ifstream in("/proc/self/smaps_rollup");
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line.compare(0, key.size(), key) == 0) {
+                return std::stoul(line.substr(key.size())) * 1024;
+            }
+        }
+        return std::nullopt;
+    }
+
+    void* AllocateLarge(size_t bytes) {
+        if (bytes < HUGE_PAGE_SIZE) {
+            return ::operator new(bytes);
+        }
+
+        const size_t length = RoundUpToHugePage(bytes);
+        if (huge_pages_mode == HugePagesMode::ON) {
+            if (void* pointer = MapExplicit(length)) {
+                AddBlock(pointer, PageKind::EXPLICIT, length);
+                return pointer;
+            }
+        }
+
+        void* pointer = MapAligned(length);
+        if (!pointer) {
+            throw std::bad_alloc();
+        }
+        PageKind kind = PageKind::REGULAR;
+#ifdef MADV_HUGEPAGE
+        if (huge_pages_mode == HugePagesMode::ON && madvise(pointer, length, MADV_HUGEPAGE) == 0) {
+            kind = PageKind::TRANSPARENT;
+        }
+#endif
+        AddBlock(pointer, kind, length);
+        return pointer;
+    }
+
+    void DeallocateLarge(void* pointer, size_t bytes) noexcept {
+        if (bytes < HUGE_PAGE_SIZE) {
+            ::operator delete(pointer);
+            return;
+        }
+
+        const size_t length = RoundUpToHugePage(bytes);
+        RemoveBlock(pointer, length);
+        munmap(pointer, length);
+    }
+}  // namespace memory
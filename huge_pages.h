@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <optional>
+
+namespace memory {
+    // Способ выделения больших блоков памяти под таблицы маршрутизации
+    enum class HugePagesMode {
+        OFF,  // обычные страницы
+        ON    // явные huge pages (MAP_HUGETLB), при их отсутствии - transparent huge pages (madvise)
+    };
+
+    // Объём памяти в байтах, выделенной каждым из способов и не освобождённой к моменту вызова
+    struct HugePagesStats {
+        size_t explicit_bytes = 0;     // MAP_HUGETLB
+        size_t transparent_bytes = 0;  // madvise(MADV_HUGEPAGE)
+        size_t regular_bytes = 0;      // обычные страницы
+        size_t blocks = 0;             // число блоков всех способов
+    };
+
+    // Размер huge page, на который выравниваются большие блоки
+    inline constexpr size_t HUGE_PAGE_SIZE = size_t{2} << 20;
+
+    void SetHugePagesMode(HugePagesMode mode);
+    [[nodiscard]] HugePagesMode GetHugePagesMode();
+    [[nodiscard]] HugePagesStats GetHugePagesStats();
+    // Объём анонимной памяти процесса, которую ядро действительно отдало huge pages (AnonHugePages
+    // в /proc/self/smaps_rollup). nullopt, если файл недоступен
+    [[nodiscard]] std::optional<size_t> GetAnonHugePagesBytes();
+
+    // Блоки от HUGE_PAGE_SIZE выделяются через mmap с выравниванием на HUGE_PAGE_SIZE, меньшие - через operator new.
+    // Способ освобождения определяется только размером блока, поэтому режим можно менять в любой момент
+    void* AllocateLarge(size_t bytes);
+    void DeallocateLarge(void* pointer, size_t bytes) noexcept;
+
+    // Аллокатор для больших массивов, которые обходятся при ответах на запросы: таблицы маршрутов и массивов графа
+    template <typename T>
+    class HugePageAllocator {
+    public:
+        using value_type = T;
+
+        HugePageAllocator() noexcept = default;
+        template <typename U>
+        HugePageAllocator(const HugePageAllocator<U>&) noexcept {
+        }
+
+        T* allocate(size_t count) {
+            if (count > std::numeric_limits<size_t>::max() / sizeof(T)) {
+                throw std::bad_array_new_length();
+            }
+            return static_cast<T*>(AllocateLarge(count * sizeof(T)));
+        }
+
+        void deallocate(T* pointer, size_t count) noexcept {
+            DeallocateLarge(pointer, count * sizeof(T));
+        }
+
+        template <typename U>
+        bool operator==(const HugePageAllocator<U>&) const noexcept {
+            return true;
+        }
+
+        template <typename U>
+        bool operator!=(const HugePageAllocator<U>&) const noexcept {
+            return false;
+        }
+    };
+}  // namespace memory
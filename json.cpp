@@ -1,4 +1,5 @@
 #include <iterator>
+#include <sstream>
 #include "json.h"
 
 namespace json {
@@ -371,6 +372,18 @@ namespace json {
             ctx.out << (value ? "true"sv : "false"sv);
         }
 
+        template <>
+        void PrintValue<Printed>(const Printed& value, const PrintContext& ctx) {
+            const std::string& text = *value.text;
+            for (size_t i = 0; i < text.size(); ++i) {
+                ctx.out.put(text[i]);
+                // Пустая строка пустого массива или словаря выводится без отступа
+                if (text[i] == '\n' && (i + 1 == text.size() || text[i + 1] != '\n')) {
+                    ctx.PrintIndent();
+                }
+            }
+        }
+
         template <>
         void PrintValue<Array>(const Array& nodes, const PrintContext& ctx) {
             std::ostream& out = ctx.out;
@@ -431,4 +444,10 @@ namespace json {
         PrintNode(doc.GetRoot(), PrintContext{output});
     }
 
+    Printed PrintToText(const Node& node) {
+        std::ostringstream out;
+        PrintNode(node, PrintContext{out});
+        return {std::make_shared<const std::string>(out.str())};
+    }
+
 }  // namespace json
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include <iostream>
 #include <map>
+#include <memory>
 #include <string>
 #include <variant>
 #include <vector>
@@ -12,13 +13,23 @@ namespace json {
     using Dict = std::map<std::string, Node>;
     using Array = std::vector<Node>;
 
+    // Значение, заранее выведенное функцией Print. Выводится как есть: строки текста сдвигаются на отступ места
+    // вывода, поэтому результат совпадает с выводом исходного значения. Копии разделяют один текст
+    struct Printed {
+        std::shared_ptr<const std::string> text;
+    };
+
+    inline bool operator==(const Printed& lhs, const Printed& rhs) {
+        return *lhs.text == *rhs.text;
+    }
+
     class ParsingError : public std::runtime_error {
     public:
         using runtime_error::runtime_error;
     };
 
     class Node final
-            : private std::variant<std::nullptr_t, Array, Dict, bool, int, double, std::string> {
+            : private std::variant<std::nullptr_t, Array, Dict, bool, int, double, std::string, Printed> {
     public:
         using variant::variant;
         using Value = variant;
@@ -96,6 +107,9 @@ namespace json {
         Node operator() (std::string value) const {
             return Node(std::move(value));
         }
+        Node operator() (Printed value) const {
+            return Node(std::move(value));
+        }
 
     };
 
@@ -103,4 +117,7 @@ namespace json {
 
     void Print(const Document& doc, std::ostream& output);
 
+    // Выводит node так же, как Print, и сохраняет текст для повторного вывода
+    Printed PrintToText(const Node& node);
+
 }  // namespace json
\ No newline at end of file
@@ -1,10 +1,19 @@
 #include <algorithm>
 #include <fstream>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <set>
+#include <stdexcept>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
+#include "huge_pages.h"
 #include "json_reader.h"
 #include "map_renderer.h"
+#include "memory_stats.h"
 #include "serialization.h"
 
 namespace transport_catalogue::reader {
@@ -14,70 +23,209 @@ namespace transport_catalogue::reader {
     using router::CustomWeight;
     using router::Item;
     using router::TransportRouter;
+    using namespace std::literals;
 
     namespace{
         //---------- BaseRequests ----------
 
-        void AddStopInCatalogue(TransportCatalogue& catalogue, const json::Dict& dict) {
-            std::string stop_name = dict.at("name").AsString();
+        using BaseInput = TransportCatalogue::BaseInput<std::string_view>;
+
+        void AddStopInBase(BaseInput& base, const json::Dict& dict) {
+            const std::string& stop_name = dict.at("name").AsString();
             double latitude = dict.at("latitude").AsDouble();
             double longitude = dict.at("longitude").AsDouble();
-            catalogue.AddStop(stop_name, {latitude, longitude});
-        }
-
-        void RequestToAddStop(TransportCatalogue& catalogue, const json::Dict& dict) {
-            const auto found_type = dict.find("type");
-            if (found_type != dict.end()) {
-                if (found_type->second.AsString() == "Stop") {
-                    AddStopInCatalogue(catalogue, dict);
-                }
+            base.stops.push_back({stop_name, {latitude, longitude}});
+            for (const auto& [to_stop_name, distance] : dict.at("road_distances").AsDict()) {
+                base.distances.push_back({stop_name, to_stop_name, distance.AsInt()});
             }
         }
 
-        void AddDistanceBetweenStops(TransportCatalogue& transport_catalog, const json::Dict& dict) {
-            const std::string& from_stop_name = dict.at("name").AsString();
-            const auto& road_distances = dict.at("road_distances").AsDict();
-            for (const auto& [to_stop_name, distance] : road_distances) {
-                transport_catalog.AddDistanceBetweenStops(from_stop_name, to_stop_name, distance.AsInt());
+        void AddRouteInBase(BaseInput& base, const json::Dict& dict) {
+            const std::string& bus_name = dict.at("name").AsString();
+            const auto& node_stops = dict.at("stops").AsArray();
+            bool is_roundtrip = dict.at("is_roundtrip").AsBool();
+
+            std::vector<std::string_view> stops;
+            stops.reserve(node_stops.size());
+            for (const auto& stop : node_stops) {
+                stops.push_back(stop.AsString());
             }
+
+            base.buses.push_back({bus_name, std::move(stops), is_roundtrip, std::nullopt});
         }
 
-        void RequestToAddDistanceBetweenStops(TransportCatalogue& catalogue, const json::Dict& dict) {
+        void RequestToAddInBase(BaseInput& base, const json::Dict& dict) {
             const auto found_type = dict.find("type");
             if (found_type != dict.end()) {
                 if (found_type->second.AsString() == "Stop") {
-                    AddDistanceBetweenStops(catalogue, dict);
+                    AddStopInBase(base, dict);
+                } else if (found_type->second.AsString() == "Bus") {
+                    AddRouteInBase(base, dict);
                 }
             }
         }
 
-        void AddRouteInCatalogue(TransportCatalogue& catalogue, const json::Dict& dict) {
-            std::string bus_name = dict.at("name").AsString();
-            const auto& node_stops = dict.at("stops").AsArray();
-            bool is_roundtrip = dict.at("is_roundtrip").AsBool();
 
-            std::vector<std::string> stops(0);
-            stops.reserve(node_stops.size());
-            for (const auto& stop : node_stops) {
-                stops.push_back(stop.AsString());
+        // Содержимое previous.catalogue с изменениями changes. Элемент с "delete": true удаляет остановку или автобус,
+        // остальные в формате base_requests добавляют или заменяют их; расстояния изменённой остановки дополняют
+        // и заменяют прежние. Остановки и автобусы сохраняют прежний порядок, новые добавляются в конец.
+        // Автобусам, которых изменения не коснулись, передаются прежние параметры маршрута, а в previous
+        // записывается, что изменилось. Бросает std::invalid_argument, если маршрут или расстояние
+        // ссылаются на удалённую или неизвестную остановку
+        BaseInput ApplyChanges(const json::Array& changes, PreviousBase& previous) {
+            const TransportCatalogue& catalogue = previous.catalogue;
+            BaseInput changed;
+            std::unordered_set<std::string_view> deleted_stops;
+            std::unordered_set<std::string_view> deleted_buses;
+            for (const json::Node& node : changes) {
+                const auto& dict = node.AsDict();
+                const auto found_delete = dict.find("delete");
+                if (found_delete == dict.end() || !found_delete->second.AsBool()) {
+                    RequestToAddInBase(changed, dict);
+                } else if (dict.at("type").AsString() == "Stop") {
+                    deleted_stops.insert(dict.at("name").AsString());
+                } else if (dict.at("type").AsString() == "Bus") {
+                    deleted_buses.insert(dict.at("name").AsString());
+                }
             }
 
-            if (!is_roundtrip) {
-                std::vector<std::string> rev_stop(stops.size() - 1);
-                std::reverse_copy(stops.begin(), stops.end() - 1, rev_stop.begin());
-                stops.insert(stops.end(), std::make_move_iterator(rev_stop.begin()), std::make_move_iterator(rev_stop.end()));
+            std::unordered_map<std::string_view, geo::Coordinates> changed_stops;
+            for (const auto& [name, coordinates] : changed.stops) {
+                changed_stops[name] = coordinates;
+                deleted_stops.erase(name);
+            }
+            std::unordered_map<std::string_view, const BaseInput::BusInput*> changed_buses;
+            for (const auto& bus : changed.buses) {
+                changed_buses[bus.number] = &bus;
+                deleted_buses.erase(bus.number);
             }
 
-            catalogue.AddRoute(bus_name, stops, is_roundtrip);
-        }
+            BaseInput result;
+            for (const domain::Stop& stop : catalogue.GetStops()) {
+                if (deleted_stops.count(stop.name)) {
+                    continue;
+                }
+                const auto found_stop = changed_stops.find(stop.name);
+                if (found_stop == changed_stops.end()) {
+                    result.stops.push_back({stop.name, stop.coordinates});
+                } else {
+                    result.stops.push_back({stop.name, found_stop->second});
+                    if (found_stop->second.lat != stop.coordinates.lat || found_stop->second.lng != stop.coordinates.lng) {
+                        previous.moved_stops.insert(stop.name);
+                    }
+                    changed_stops.erase(found_stop);
+                }
+            }
+            for (const auto& stop : changed.stops) {
+                if (const auto found_stop = changed_stops.find(stop.name); found_stop != changed_stops.end()) {
+                    result.stops.push_back({stop.name, found_stop->second});
+                    changed_stops.erase(found_stop);
+                }
+            }
+            std::unordered_set<std::string_view> stop_names;
+            for (const auto& stop : result.stops) {
+                stop_names.insert(stop.name);
+            }
+            const auto check_stop = [&](std::string_view stop_name, const std::string& user) {
+                if (!stop_names.count(stop_name)) {
+                    throw std::invalid_argument(user + (deleted_stops.count(stop_name) ? " uses deleted stop "s
+                                                                                       : " uses unknown stop "s)
+                                                + std::string{stop_name});
+                }
+            };
 
-        void RequestToAddRouteStop(TransportCatalogue& catalogue, const json::Dict& dict) {
-            const auto found_type = dict.find("type");
-            if (found_type != dict.end()) {
-                if (found_type->second.AsString() == "Bus") {
-                    AddRouteInCatalogue(catalogue, dict);
+            // Из прежних расстояний достаточно явно заданных: обратные направления AddBase восстановит сам
+            std::set<std::pair<std::string_view, std::string_view>> changed_distances;
+            // Расстояния, значение которых действительно изменилось: повторно переданные прежние не в счёт
+            std::set<std::pair<std::string_view, std::string_view>> modified_distances;
+            for (const auto& distance : changed.distances) {
+                check_stop(distance.to_stop, "Road distance from stop "s + std::string{distance.from_stop});
+                changed_distances.emplace(distance.from_stop, distance.to_stop);
+                const domain::StopId from_stop = catalogue.FindStopId(distance.from_stop);
+                const domain::StopId to_stop = catalogue.FindStopId(distance.to_stop);
+                const auto* old_distance = from_stop != domain::NO_ID && to_stop != domain::NO_ID
+                                           ? catalogue.FindRoadDistance(from_stop, to_stop) : nullptr;
+                if (!old_distance || !old_distance->is_explicit || old_distance->distance != distance.distance) {
+                    modified_distances.emplace(distance.from_stop, distance.to_stop);
+                }
+            }
+            for (domain::StopId from_stop = 0; from_stop < catalogue.GetStops().size(); ++from_stop) {
+                const std::string_view from_name = catalogue.GetStop(from_stop).name;
+                for (const auto& [to_stop, distance, is_explicit] : catalogue.GetRoadDistances(from_stop)) {
+                    const std::string_view to_name = catalogue.GetStop(to_stop).name;
+                    if (is_explicit && !deleted_stops.count(from_name) && !deleted_stops.count(to_name)
+                        && !changed_distances.count({from_name, to_name})) {
+                        result.distances.push_back({from_name, to_name, distance});
+                    }
+                }
+            }
+            result.distances.insert(result.distances.end(), changed.distances.begin(), changed.distances.end());
+
+            // Расстояние между соседними остановками может браться из обратного направления,
+            // поэтому маршрут затрагивает изменение расстояния в любую сторону
+            const auto is_distance_changed = [&modified_distances](std::string_view from_stop, std::string_view to_stop) {
+                return modified_distances.count({from_stop, to_stop}) || modified_distances.count({to_stop, from_stop});
+            };
+            const auto touch_stops = [&previous](const std::vector<std::string_view>& stops) {
+                previous.touched_stops.insert(stops.begin(), stops.end());
+            };
+            for (const domain::Bus& bus : catalogue.GetBuses()) {
+                std::vector<std::string_view> stops;
+                stops.reserve(bus.stops.size());
+                for (const domain::StopId stop : bus.stops) {
+                    stops.push_back(catalogue.GetStop(stop).name);
+                }
+                if (deleted_buses.count(bus.number)) {
+                    touch_stops(stops);
+                    continue;
+                }
+                const auto found_bus = changed_buses.find(bus.number);
+                if (found_bus != changed_buses.end()) {
+                    touch_stops(stops);
+                    touch_stops(found_bus->second->stops);
+                    previous.changed_buses.insert(bus.number);
+                    result.buses.push_back(*found_bus->second);
+                    changed_buses.erase(found_bus);
+                    continue;
+                }
+
+                // Перемещение остановки меняет извилистость и линию на карте, но не рёбра графа
+                bool is_moved = false;
+                bool is_distance_changed_on_route = false;
+                for (size_t index = 0; index < stops.size(); ++index) {
+                    check_stop(stops[index], "Bus "s + std::string{bus.number});
+                    is_moved = is_moved || previous.moved_stops.count(stops[index]);
+                    if (index > 0 && is_distance_changed(stops[index - 1], stops[index])) {
+                        is_distance_changed_on_route = true;
+                    }
+                }
+                if (is_distance_changed_on_route) {
+                    touch_stops(stops);
+                }
+                if (is_moved || is_distance_changed_on_route) {
+                    previous.changed_buses.insert(bus.number);
+                    result.buses.push_back({bus.number, std::move(stops), bus.is_roundtrip, std::nullopt});
+                } else {
+                    result.buses.push_back({bus.number, std::move(stops), bus.is_roundtrip,
+                                            TransportCatalogue::GetRouteStats(bus)});
                 }
             }
+            for (const auto& bus : changed.buses) {
+                if (const auto found_bus = changed_buses.find(bus.number); found_bus != changed_buses.end()) {
+                    touch_stops(bus.stops);
+                    previous.changed_buses.insert(bus.number);
+                    result.buses.push_back(*found_bus->second);
+                    changed_buses.erase(found_bus);
+                }
+            }
+            for (const auto& bus : result.buses) {
+                if (previous.changed_buses.count(bus.number)) {
+                    for (const std::string_view stop : bus.stops) {
+                        check_stop(stop, "Bus "s + std::string{bus.number});
+                    }
+                }
+            }
+            return result;
         }
 
 
@@ -126,24 +274,136 @@ namespace transport_catalogue::reader {
             return settings;
         }
 
+        // Примитивы прежней карты, которые переносятся в новую без пересчёта
+        struct ReusableMap {
+            struct BusPrimitives {
+                size_t route = 0;       // номер линии в MapRenderer::GetRoutes
+                size_t first_name = 0;  // номер первой надписи в MapRenderer::GetRoutesNames
+                size_t name_count = 0;
+                size_t color = 0;       // номер цвета в палитре
+            };
+
+            const MapRenderer& map_renderer;
+            // Автобусы, которых не коснулись изменения
+            std::unordered_map<std::string_view, BusPrimitives> buses;
+            // Номера неперемещённых остановок в MapRenderer::GetStops и GetStopsNames
+            std::unordered_map<std::string_view, size_t> stops;
+        };
+
+        // Остановки, через которые проходят автобусы, в порядке справочника
+        std::vector<const domain::Stop*> FindStopsToDraw(const TransportCatalogue& catalogue) {
+            std::vector<const domain::Stop*> stops_to_draw;
+            for (const auto& stop : catalogue.GetStops()) {
+                if (!catalogue.GetBusesAtStop(stop.id).empty()) {
+                    stops_to_draw.push_back(&stop);
+                }
+            }
+            return stops_to_draw;
+        }
+
+        renderer::SphereProjector BuildSphereProjector(const std::vector<const domain::Stop*>& stops_to_draw,
+                                                       const RenderSettings& settings) {
+            std::vector<geo::Coordinates> coordinates;
+            coordinates.reserve(stops_to_draw.size());
+            for (const domain::Stop* stop : stops_to_draw) {
+                coordinates.push_back(stop->coordinates);
+            }
+            return {coordinates.begin(), coordinates.end(), settings.width, settings.height, settings.padding};
+        }
+
+        void SortStopsByName(std::vector<const domain::Stop*>& stops) {
+            std::sort(stops.begin(), stops.end(), [](const domain::Stop* lhs, const domain::Stop* rhs) {
+                return lhs->name < rhs->name;
+            });
+        }
+
+        // Примитивы карты previous, которые можно взять в новую карту с теми же настройками settings.
+        // nullopt, если проекция сдвинулась: тогда меняются точки всех примитивов
+        std::optional<ReusableMap> FindReusableMap(const PreviousBase& previous, const RenderSettings& settings,
+                                                   const renderer::SphereProjector& sphere_projector) {
+            const TransportCatalogue& catalogue = previous.catalogue;
+            std::vector<const domain::Stop*> stops_to_draw = FindStopsToDraw(catalogue);
+            if (!(BuildSphereProjector(stops_to_draw, settings) == sphere_projector)) {
+                return std::nullopt;
+            }
+
+            ReusableMap result{previous.map_renderer, {}, {}};
+            const size_t color_size = settings.color_palette.size();
+            size_t route = 0;
+            size_t name = 0;
+            for (const domain::BusId bus_id : catalogue.GetBusIdsByName()) {
+                const domain::Bus& bus = catalogue.GetBus(bus_id);
+                if (bus.stops.empty()) {
+                    continue;
+                }
+                const size_t name_count = !bus.is_roundtrip && bus.stops.front() != bus.stops.back() ? 2 : 1;
+                if (!previous.changed_buses.count(bus.number)) {
+                    result.buses[bus.number] = {route, name, name_count, color_size > 0 ? route % color_size : 0};
+                }
+                ++route;
+                name += name_count;
+            }
+            if (route != previous.map_renderer.GetRoutes().size() || name != previous.map_renderer.GetRoutesNames().size()
+                || stops_to_draw.size() != previous.map_renderer.GetStops().size()) {
+                return std::nullopt;
+            }
+
+            SortStopsByName(stops_to_draw);
+            for (size_t index = 0; index < stops_to_draw.size(); ++index) {
+                if (!previous.moved_stops.count(stops_to_draw[index]->name)) {
+                    result.stops[stops_to_draw[index]->name] = index;
+                }
+            }
+            return result;
+        }
+
+        // Прежние примитивы автобуса, если их можно взять: автобус не изменился и сохранил цвет
+        const ReusableMap::BusPrimitives* FindBusPrimitives(const ReusableMap* reusable, std::string_view bus_name,
+                                                            size_t color) {
+            if (!reusable) {
+                return nullptr;
+            }
+            const auto found_bus = reusable->buses.find(bus_name);
+            return found_bus != reusable->buses.end() && found_bus->second.color == color ? &found_bus->second : nullptr;
+        }
+
+        // Номер прежних примитивов остановки, если она была на карте и не сдвинулась
+        std::optional<size_t> FindStopPrimitives(const ReusableMap* reusable, std::string_view stop_name) {
+            if (!reusable) {
+                return std::nullopt;
+            }
+            const auto found_stop = reusable->stops.find(stop_name);
+            return found_stop != reusable->stops.end() ? std::optional<size_t>{found_stop->second} : std::nullopt;
+        }
+
         std::vector<renderer::RouteRenderer> AddRoutesRenderer(const TransportCatalogue& catalogue, const RenderSettings& settings,
-                                                               const renderer::SphereProjector& sphere_projector) {
+                                                               const renderer::SphereProjector& sphere_projector,
+                                                               const ReusableMap* reusable) {
 
-            const TransportCatalogue::RouteMap& routes = catalogue.GetRoutes();
+            const std::vector<domain::BusId> bus_ids = catalogue.GetBusIdsByName();
             std::vector<renderer::RouteRenderer> routes_coordinates;
-            routes_coordinates.reserve(routes.size());
+            routes_coordinates.reserve(bus_ids.size());
             const size_t color_size = settings.color_palette.size();
             size_t number = 0;
-            for (const auto& [bus_name, stops_at_route] : routes) {
+            for (const domain::BusId bus_id : bus_ids) {
+                const domain::Bus& bus = catalogue.GetBus(bus_id);
+                const auto& stops_at_route = bus.stops;
                 std::vector<svg::Point> points;
                 if (!stops_at_route.empty()) {
                     if (number >= color_size) {
                         number = 0;
                     }
-                    for (const auto& stop : stops_at_route) {
-                        points.push_back(sphere_projector(catalogue.FindStop(stop)->coordinates));
+                    if (const auto* primitives = FindBusPrimitives(reusable, bus.number, number)) {
+                        routes_coordinates.push_back(reusable->map_renderer.GetRoutes()[primitives->route]);
+                        ++number;
+                        continue;
+                    }
+                    points.reserve(stops_at_route.size());
+                    for (const domain::StopId stop : stops_at_route) {
+                        points.push_back(sphere_projector(catalogue.GetStop(stop).coordinates));
                     }
-                    routes_coordinates.emplace_back(points, settings.color_palette[number], settings.line_width);
+                    routes_coordinates.emplace_back(std::move(points), settings.color_palette[number], settings.line_width,
+                                                    bus.is_roundtrip);
                     ++number;
                 }
             }
@@ -151,24 +411,33 @@ namespace transport_catalogue::reader {
         }
 
         std::vector<renderer::TextRenderer> AddRoutesNames(const TransportCatalogue& catalogue, const RenderSettings& settings,
-                                                           const renderer::SphereProjector& sphere_projector) {
-            const TransportCatalogue::RouteMap& routes = catalogue.GetRoutes();
+                                                           const renderer::SphereProjector& sphere_projector,
+                                                           const ReusableMap* reusable) {
             std::vector<renderer::TextRenderer> routes_names;
             const size_t color_size = settings.color_palette.size();
             size_t number = 0;
-            for (const auto& [bus_name, stops_at_route] : routes) {
+            for (const domain::BusId bus_id : catalogue.GetBusIdsByName()) {
+                const domain::Bus& bus = catalogue.GetBus(bus_id);
+                const std::string_view bus_name = bus.number;
+                const auto& stops_at_route = bus.stops;
                 if (!stops_at_route.empty()) {
                     if (number >= color_size) {
                         number = 0;
                     }
-                    const auto first_stop = catalogue.FindStop(stops_at_route.front());
-                    const auto end_stop = catalogue.FindStop(stops_at_route[stops_at_route.size() / 2]);
-                    const svg::Point position = sphere_projector(catalogue.FindStop(stops_at_route.front())->coordinates);
+                    if (const auto* primitives = FindBusPrimitives(reusable, bus_name, number)) {
+                        const auto names_begin = reusable->map_renderer.GetRoutesNames().begin() + primitives->first_name;
+                        routes_names.insert(routes_names.end(), names_begin, names_begin + primitives->name_count);
+                        ++number;
+                        continue;
+                    }
+                    const domain::StopId first_stop = stops_at_route.front();
+                    const domain::StopId end_stop = stops_at_route.back();
+                    const svg::Point position = sphere_projector(catalogue.GetStop(first_stop).coordinates);
                     routes_names.emplace_back(position, settings.bus_label_offset, static_cast<uint32_t>(settings.bus_label_font_size),
                                               "bold", std::string(bus_name), settings.underlayer_color, settings.underlayer_width,
                                               settings.color_palette[number]);
-                    if (!catalogue.FindRoute(bus_name)->is_roundtrip && first_stop != end_stop) {
-                        const svg::Point back_position = sphere_projector(catalogue.FindStop(stops_at_route[stops_at_route.size() / 2])->coordinates);
+                    if (!bus.is_roundtrip && first_stop != end_stop) {
+                        const svg::Point back_position = sphere_projector(catalogue.GetStop(end_stop).coordinates);
                         routes_names.emplace_back(back_position, settings.bus_label_offset, static_cast<uint32_t>(settings.bus_label_font_size),
                                                   "bold", std::string(bus_name), settings.underlayer_color, settings.underlayer_width,
                                                   settings.color_palette[number]);
@@ -180,23 +449,33 @@ namespace transport_catalogue::reader {
             return routes_names;
         }
 
-        std::vector<renderer::StopRenderer> AddStopsRenderer(const TransportCatalogue& catalogue, const std::set<std::string_view>& ordered_stops,
-                                                             const RenderSettings& settings, const renderer::SphereProjector& sphere_projector) {
+        std::vector<renderer::StopRenderer> AddStopsRenderer(const std::vector<const domain::Stop*>& ordered_stops,
+                                                             const RenderSettings& settings, const renderer::SphereProjector& sphere_projector,
+                                                             const ReusableMap* reusable) {
             std::vector<renderer::StopRenderer> stops_for_draw;
             stops_for_draw.reserve(ordered_stops.size());
-            for (const auto& stop : ordered_stops) {
-                stops_for_draw.emplace_back(sphere_projector(catalogue.FindStop(stop)->coordinates), settings.stop_radius);
+            for (const domain::Stop* stop : ordered_stops) {
+                if (const auto index = FindStopPrimitives(reusable, stop->name)) {
+                    stops_for_draw.push_back(reusable->map_renderer.GetStops()[*index]);
+                } else {
+                    stops_for_draw.emplace_back(sphere_projector(stop->coordinates), settings.stop_radius);
+                }
             }
             return stops_for_draw;
         }
 
-        std::vector<renderer::TextRenderer> AddStopsNames(const TransportCatalogue& catalogue, const std::set<std::string_view>& ordered_stops,
-                                                          const RenderSettings& settings, const renderer::SphereProjector& sphere_projector) {
+        std::vector<renderer::TextRenderer> AddStopsNames(const std::vector<const domain::Stop*>& ordered_stops,
+                                                          const RenderSettings& settings, const renderer::SphereProjector& sphere_projector,
+                                                          const ReusableMap* reusable) {
             std::vector<renderer::TextRenderer> stops_for_draw;
             stops_for_draw.reserve(ordered_stops.size());
-            for (const auto& stop : ordered_stops) {
-                stops_for_draw.emplace_back(sphere_projector(catalogue.FindStop(stop)->coordinates), settings.stop_label_offset,
-                                            settings.stop_label_font_size, std::nullopt, std::string{stop},
+            for (const domain::Stop* stop : ordered_stops) {
+                if (const auto index = FindStopPrimitives(reusable, stop->name)) {
+                    stops_for_draw.push_back(reusable->map_renderer.GetStopsNames()[*index]);
+                    continue;
+                }
+                stops_for_draw.emplace_back(sphere_projector(stop->coordinates), settings.stop_label_offset,
+                                            settings.stop_label_font_size, std::nullopt, std::string{stop->name},
                                             settings.underlayer_color, settings.underlayer_width, "black");
             }
             return stops_for_draw;
@@ -207,7 +486,7 @@ namespace transport_catalogue::reader {
         json::Node GetBusInfo(const RequestHandler& request_hand, const json::Dict& dict) {
             const std::string& bus_name = dict.at("name").AsString();
             int id = dict.at("id").AsInt();
-            domain::Bus* bus_ptr = request_hand.GetBusStat(bus_name);
+            const domain::Bus* bus_ptr = request_hand.GetBusStat(bus_name);
             json::Builder json_builder;
             json_builder.StartDict().Key("request_id").Value(id);
             if (!bus_ptr) {
@@ -231,7 +510,42 @@ namespace transport_catalogue::reader {
                 json_builder.Key("error_message").Value(std::string("not found"));
             } else {
                 json_builder.Key("buses").StartArray();
-                for (std::string_view bus : *buses_by_stop) {
+                for (const domain::BusId bus : *buses_by_stop) {
+                    json_builder.Value(std::string(request_hand.GetBusName(bus)));
+                }
+                json_builder.EndArray();
+            }
+            return json_builder.EndDict().Build();
+        }
+
+        json::Node GetBusInfo(const snapshot::CatalogueSnapshot& catalogue, const json::Dict& dict) {
+            const std::string& bus_name = dict.at("name").AsString();
+            int id = dict.at("id").AsInt();
+            const auto bus_stat = catalogue.FindBusStat(bus_name);
+            json::Builder json_builder;
+            json_builder.StartDict().Key("request_id").Value(id);
+            if (!bus_stat) {
+                json_builder.Key("error_message").Value(std::string("not found"));
+            } else {
+                json_builder.Key("curvature").Value(bus_stat->curvature);
+                json_builder.Key("route_length").Value(bus_stat->route_length);
+                json_builder.Key("stop_count").Value(bus_stat->stops_on_route);
+                json_builder.Key("unique_stop_count").Value(bus_stat->unique_stops);
+            }
+            return json_builder.EndDict().Build();
+        }
+
+        json::Node GetStopInfo(const snapshot::CatalogueSnapshot& catalogue, const json::Dict& dict) {
+            const std::string& stop_name = dict.at("name").AsString();
+            int id = dict.at("id").AsInt();
+            const auto buses_by_stop = catalogue.FindBusesAtStop(stop_name);
+            json::Builder json_builder;
+            json_builder.StartDict().Key("request_id").Value(id);
+            if (!buses_by_stop) {
+                json_builder.Key("error_message").Value(std::string("not found"));
+            } else {
+                json_builder.Key("buses").StartArray();
+                for (const std::string_view bus : *buses_by_stop) {
                     json_builder.Value(std::string(bus));
                 }
                 json_builder.EndArray();
@@ -239,6 +553,158 @@ namespace transport_catalogue::reader {
             return json_builder.EndDict().Build();
         }
 
+        // Применяет изменения из "base_requests" запроса: формат тот же, что у base_requests в make_base
+        json::Node UpdateCatalogue(snapshot::CatalogueStore& catalogue_store, const json::Dict& dict) {
+            int id = dict.at("id").AsInt();
+            BaseInput changes;
+            for (const json::Node& node : dict.at("base_requests").AsArray()) {
+                RequestToAddInBase(changes, node.AsDict());
+            }
+            json::Builder json_builder;
+            json_builder.StartDict().Key("request_id").Value(id);
+            try {
+                catalogue_store.Update(changes);
+            } catch (const std::out_of_range&) {
+                json_builder.Key("error_message").Value(std::string("not found"));
+            }
+            return json_builder.EndDict().Build();
+        }
+
+        // "count" (по умолчанию 1) ближайших к точке остановок или, если задан "radius" в метрах, все остановки
+        // в его пределах (не больше "count", если он задан)
+        json::Node GetNearestStopsInfo(const RequestHandler& request_hand, const json::Dict& dict) {
+            int id = dict.at("id").AsInt();
+            const geo::Coordinates point{dict.at("latitude").AsDouble(), dict.at("longitude").AsDouble()};
+            const auto found_radius = dict.find("radius");
+            const auto found_count = dict.find("count");
+            std::optional<double> radius;
+            size_t count = 1;
+            if (found_radius != dict.end()) {
+                radius = found_radius->second.AsDouble();
+                count = std::numeric_limits<size_t>::max();
+            }
+            if (found_count != dict.end()) {
+                count = static_cast<size_t>(std::max(found_count->second.AsInt(), 0));
+            }
+            const std::vector<RequestHandler::Neighbour> neighbours = request_hand.GetNearestStops(point, count, radius);
+
+            json::Builder json_builder;
+            json_builder.StartDict().Key("request_id").Value(id).Key("stops").StartArray();
+            for (const auto& [stop, distance] : neighbours) {
+                json_builder.StartDict()
+                        .Key("name").Value(std::string(request_hand.GetStopName(stop)))
+                        .Key("distance").Value(distance)
+                        .EndDict();
+            }
+            return json_builder.EndArray().EndDict().Build();
+        }
+
+        // Остановки внутри прямоугольника и автобусы, маршрут которых через него проходит, по возрастанию названий
+        json::Node GetViewportInfo(const RequestHandler& request_hand, const json::Dict& dict) {
+            int id = dict.at("id").AsInt();
+            const spatial::GeoBox box{{dict.at("min_latitude").AsDouble(), dict.at("min_longitude").AsDouble()},
+                                      {dict.at("max_latitude").AsDouble(), dict.at("max_longitude").AsDouble()}};
+
+            json::Builder json_builder;
+            json_builder.StartDict().Key("request_id").Value(id).Key("stops").StartArray();
+            for (const domain::StopId stop : request_hand.GetStopsInBox(box)) {
+                json_builder.Value(std::string(request_hand.GetStopName(stop)));
+            }
+            json_builder.EndArray().Key("buses").StartArray();
+            for (const domain::BusId bus : request_hand.GetBusesInBox(box)) {
+                json_builder.Value(std::string(request_hand.GetBusName(bus)));
+            }
+            return json_builder.EndArray().EndDict().Build();
+        }
+
+        // Автобусы от остановки "from" до остановки "to" без пересадок с направлением поездки по маршруту
+        json::Node GetDirectBusesInfo(const RequestHandler& request_hand, const json::Dict& dict) {
+            int id = dict.at("id").AsInt();
+            const auto direct_buses = request_hand.GetDirectBuses(dict.at("from").AsString(), dict.at("to").AsString());
+
+            json::Builder json_builder;
+            json_builder.StartDict().Key("request_id").Value(id);
+            if (!direct_buses) {
+                return json_builder.Key("error_message").Value(std::string("not found")).EndDict().Build();
+            }
+            json_builder.Key("buses").StartArray();
+            for (const auto& [bus, direction] : *direct_buses) {
+                json_builder.StartDict()
+                        .Key("bus").Value(std::string(request_hand.GetBusName(bus)))
+                        .Key("direction").Value(std::string(direction == connection::Direction::FORWARD ? "forward"
+                                                                                                        : "backward"))
+                        .EndDict();
+            }
+            return json_builder.EndArray().EndDict().Build();
+        }
+
+        // Число остановок в ответе на SearchStops, если "count" не задан
+        const size_t DEFAULT_SEARCH_COUNT = 10;
+
+        // Поиск остановок по названию: "mode" "prefix" (по умолчанию) - по началу названия, "fuzzy" - с опечатками,
+        // не больше "max_distance" (по умолчанию 1). Не больше "count" (по умолчанию 10) остановок
+        json::Node GetSearchStopsInfo(const RequestHandler& request_hand, const json::Dict& dict) {
+            int id = dict.at("id").AsInt();
+            const std::string& query = dict.at("query").AsString();
+            const auto found_count = dict.find("count");
+            const size_t count = found_count != dict.end()
+                    ? static_cast<size_t>(std::max(found_count->second.AsInt(), 0))
+                    : DEFAULT_SEARCH_COUNT;
+            std::optional<size_t> max_distance;
+            const auto found_mode = dict.find("mode");
+            if (found_mode != dict.end() && found_mode->second.AsString() == "fuzzy") {
+                const auto found_max_distance = dict.find("max_distance");
+                max_distance = found_max_distance != dict.end()
+                        ? static_cast<size_t>(std::max(found_max_distance->second.AsInt(), 0))
+                        : 1;
+            }
+
+            json::Builder json_builder;
+            json_builder.StartDict().Key("request_id").Value(id).Key("stops").StartArray();
+            for (const auto& [stop, bus_count] : request_hand.SearchStops(query, count, max_distance)) {
+                json_builder.StartDict()
+                        .Key("name").Value(std::string(request_hand.GetStopName(stop)))
+                        .Key("bus_count").Value(static_cast<int>(bus_count))
+                        .EndDict();
+            }
+            return json_builder.EndArray().EndDict().Build();
+        }
+
+        // Индексы запросов NearestStops, Viewport, DirectBuses и SearchStops по версии справочника, опубликованной
+        // запросами Update. Версия собирается в отдельный справочник, индексы по нему строятся заново
+        class VersionIndexes {
+        public:
+            VersionIndexes(const snapshot::CatalogueSnapshot& snapshot, const RequestHandler& request_hand)
+                : version_(snapshot.GetVersion())
+                , catalogue_(snapshot.ToCatalogue())
+                , stop_index_(*catalogue_)
+                , route_bounds_(*catalogue_)
+                , direct_buses_(*catalogue_)
+                , name_index_(*catalogue_)
+                , request_hand_(request_hand.WithCatalogue(*catalogue_, &stop_index_, &route_bounds_, &direct_buses_,
+                                                           &name_index_)) {
+            }
+            VersionIndexes(const VersionIndexes&) = delete;
+            VersionIndexes& operator=(const VersionIndexes&) = delete;
+
+            [[nodiscard]] uint64_t GetVersion() const {
+                return version_;
+            }
+
+            [[nodiscard]] const RequestHandler& GetRequestHandler() const {
+                return request_hand_;
+            }
+
+        private:
+            uint64_t version_;
+            std::shared_ptr<const TransportCatalogue> catalogue_;
+            spatial::StopSpatialIndex stop_index_;
+            spatial::RouteBoundsIndex route_bounds_;
+            connection::DirectBusesIndex direct_buses_;
+            search::StopNameIndex name_index_;
+            RequestHandler request_hand_;
+        };
+
         json::Node GetMapInfo(const RequestHandler& request_hand, const json::Dict& dict) {
             svg::Document doc = request_hand.RenderMap();
             int id = dict.at("id").AsInt();
@@ -250,11 +716,8 @@ namespace transport_catalogue::reader {
             return json::Builder{}.StartDict().Key("request_id").Value(id).Key("map").Value(strm.str()).EndDict().Build();
         }
 
-        json::Node GetRouteInfo(const RequestHandler& request_hand, const json::Dict& dict) {
+        json::Node BuildRouteInfo(const request_handler::RouteInfoPtr& items, const json::Dict& dict) {
             int id = dict.at("id").AsInt();
-            const std::string& from = dict.at("from").AsString();
-            const std::string& to = dict.at("to").AsString();
-            const auto items = request_hand.GetItems(from, to);
             json::Builder json_builder;
             json_builder.StartDict().Key("request_id").Value(id);
             if (!items) {
@@ -265,135 +728,462 @@ namespace transport_catalogue::reader {
             }
             return json_builder.EndDict().Build();
         }
-    }
 
-    void BaseRequests(TransportCatalogue& catalogue, const json::Array& arr) {
-        for (const json::Node& node : arr) {
-            RequestToAddStop(catalogue, node.AsDict());
+        json::Node GetRouteInfo(const RequestHandler& request_hand, const json::Dict& dict) {
+            const std::string& from = dict.at("from").AsString();
+            const std::string& to = dict.at("to").AsString();
+            return BuildRouteInfo(request_hand.GetItems(from, to), dict);
         }
 
-        for (const json::Node& node : arr) {
-            RequestToAddDistanceBetweenStops(catalogue, node.AsDict());
+        bool IsRouteRequest(const json::Dict& dict) {
+            const auto found_type = dict.find("type");
+            return found_type != dict.end() && found_type->second.AsString() == "Route";
         }
 
-        for (const json::Node& node : arr) {
-            RequestToAddRouteStop(catalogue, node.AsDict());
+        // Заранее строит ответы на все запросы Route в порядке (from, to)
+        std::vector<request_handler::RouteInfoPtr> GetSortedRoutes(const RequestHandler& request_hand,
+                                                                   const json::Array& requests) {
+            std::vector<RequestHandler::StopsPair> routes;
+            for (const auto& request : requests) {
+                const auto& dict = request.AsDict();
+                if (IsRouteRequest(dict)) {
+                    routes.emplace_back(dict.at("from").AsString(), dict.at("to").AsString());
+                }
+            }
+            return request_hand.GetItemsSorted(routes);
         }
-    }
 
-    MapRenderer RenderSettingsRequests(const TransportCatalogue& catalogue, const RenderSettings& settings) {
-        MapRenderer map_renderer;
-        const auto& stops = catalogue.GetStops();
-        std::vector<geo::Coordinates> stops_to_draw;
-        std::set<std::string_view> ordered_stops;
+        //---------- MemoryStats -----------
+
+        using MemoryComponent = memory::MemoryReport::Component;
+
+        // Числа, не помещающиеся в int, выводятся как double
+        json::Node ToJsonNumber(int64_t value) {
+            if (value >= std::numeric_limits<int>::min() && value <= std::numeric_limits<int>::max()) {
+                return static_cast<int>(value);
+            }
+            return static_cast<double>(value);
+        }
+
+        // Добавляет в отчёт, если он задан, память, выделенную с прошлого замера, и начинает новый замер
+        MemoryComponent* AddToReport(memory::MemoryReport* memory_report, std::string name,
+                                     memory::AllocationScope& allocation_scope) {
+            const memory::MemoryUsage usage = allocation_scope.Restart();
+            return memory_report ? &memory_report->Add(std::move(name), usage) : nullptr;
+        }
+
+        void AddCatalogueDetails(MemoryComponent* component, const TransportCatalogue& catalogue) {
+            if (!component) {
+                return;
+            }
+            size_t route_stops = 0;
+            size_t route_stops_bytes = 0;
+            for (const domain::Bus& bus : catalogue.GetBuses()) {
+                route_stops += bus.stops.size();
+                route_stops_bytes += memory::GetVectorBlockSize(bus.stops);
+            }
+            size_t distances = 0;
+            for (domain::StopId stop = 0; stop < catalogue.GetStops().size(); ++stop) {
+                distances += catalogue.GetRoadDistances(stop).size();
+            }
+            component->details = {
+                    {"stops", catalogue.GetStops().size()},
+                    {"buses", catalogue.GetBuses().size()},
+                    {"route_stops", route_stops},
+                    {"route_stops_bytes", route_stops_bytes},
+                    {"distances", distances},
+            };
+        }
+
+        void AddMapRendererDetails(MemoryComponent* component, const MapRenderer& map_renderer) {
+            if (!component) {
+                return;
+            }
+            size_t route_points = 0;
+            for (const auto& route : map_renderer.GetRoutes()) {
+                route_points += route.GetStopCoordinates().size();
+            }
+            component->details = {
+                    {"routes", map_renderer.GetRoutes().size()},
+                    {"route_points", route_points},
+                    {"route_labels", map_renderer.GetRoutesNames().size()},
+                    {"stops", map_renderer.GetStops().size()},
+                    {"stop_labels", map_renderer.GetStopsNames().size()},
+            };
+        }
+
+        void AddTransportRouterDetails(MemoryComponent* component, const TransportRouter& transport_router) {
+            if (!component) {
+                return;
+            }
+            component->details = {
+                    {"vertices", transport_router.GetGraph().GetVertexCount()},
+                    {"edges", transport_router.GetGraph().GetEdgeCount()},
+                    {"items", transport_router.GetItems().size()},
+                    {"items_bytes", memory::GetVectorBlockSize(transport_router.GetItems())},
+            };
+        }
 
-        for (const auto& stop : stops) {
-            if (!catalogue.FindBusesAtStops(stop.name).empty()) {
-                stops_to_draw.push_back(stop.coordinates);
-                ordered_stops.insert(stop.name);
+        void AddRouterDetails(MemoryComponent* component, const graph::Router<router::Minutes>& router,
+                              const TransportRouter& transport_router) {
+            if (!component) {
+                return;
             }
+            const size_t vertex_count = transport_router.GetGraph().GetVertexCount();
+            component->details = {
+                    {"sources", router.GetSourceCount()},
+                    {"table_entries", router.GetSourceCount() * vertex_count},
+            };
+        }
+
+        bool HasMemoryStatsRequest(const json::Array& stat_requests) {
+            return std::any_of(stat_requests.begin(), stat_requests.end(), [](const json::Node& request) {
+                const auto& dict = request.AsDict();
+                const auto found_type = dict.find("type");
+                return found_type != dict.end() && found_type->second.AsString() == "MemoryStats";
+            });
+        }
+
+        // Память компонентов, замеренная при загрузке базы, и вся занятая процессом память на момент запроса
+        json::Node GetMemoryStatsInfo(const memory::MemoryReport& memory_report, const json::Dict& dict) {
+            json::Dict result = BuildMemoryReport(memory_report);
+            result.emplace("request_id", dict.at("id").AsInt());
+            return result;
         }
-        renderer::SphereProjector sphere_projector(stops_to_draw.begin(), stops_to_draw.end(),
-                                                   settings.width, settings.height, settings.padding);
+    }
+
+    void BaseRequests(TransportCatalogue& catalogue, const json::Array& arr) {
+        BaseInput base;
+        for (const json::Node& node : arr) {
+            RequestToAddInBase(base, node.AsDict());
+        }
+        catalogue.AddBase(base);
+    }
+
+    // Если previous задан, примитивы автобусов и остановок, которых не коснулись изменения, берутся из его карты,
+    // когда проекция не сдвинулась
+    MapRenderer RenderSettingsRequests(const TransportCatalogue& catalogue, const RenderSettings& settings,
+                                       const PreviousBase* previous) {
+        MapRenderer map_renderer;
+        std::vector<const domain::Stop*> ordered_stops = FindStopsToDraw(catalogue);
+        const renderer::SphereProjector sphere_projector = BuildSphereProjector(ordered_stops, settings);
+        SortStopsByName(ordered_stops);
 
-        map_renderer.SetRoutes(AddRoutesRenderer(catalogue, settings, sphere_projector));
-        map_renderer.SetRoutesNames(AddRoutesNames(catalogue, settings, sphere_projector));
-        map_renderer.SetStops(AddStopsRenderer(catalogue, ordered_stops, settings, sphere_projector));
-        map_renderer.SetStopsNames(AddStopsNames(catalogue, ordered_stops, settings, sphere_projector));
+        const std::optional<ReusableMap> reusable = previous ? FindReusableMap(*previous, settings, sphere_projector)
+                                                             : std::nullopt;
+        const ReusableMap* reusable_map = reusable ? &*reusable : nullptr;
+        map_renderer.SetRoutes(AddRoutesRenderer(catalogue, settings, sphere_projector, reusable_map));
+        map_renderer.SetRoutesNames(AddRoutesNames(catalogue, settings, sphere_projector, reusable_map));
+        map_renderer.SetStops(AddStopsRenderer(ordered_stops, settings, sphere_projector, reusable_map));
+        map_renderer.SetStopsNames(AddStopsNames(ordered_stops, settings, sphere_projector, reusable_map));
         return map_renderer;
     }
 
-    void RoutingSettingsRequest(TransportRouter& transport_router, const json::Dict& dict) {
+    void RoutingSettingsRequest(TransportRouter& transport_router, const json::Dict& dict, const PreviousBase* previous) {
         router::Minutes bus_wait_time = dict.at("bus_wait_time").AsDouble();
-        transport_router.AddStops(bus_wait_time);
+        router::VertexOrder vertex_order = router::VertexOrder::CATALOGUE;
+        const auto found_vertex_order = dict.find("vertex_order");
+        if (found_vertex_order != dict.end() && found_vertex_order->second.AsString() == "hilbert") {
+            vertex_order = router::VertexOrder::HILBERT;
+        }
+        transport_router.AddStops(bus_wait_time, vertex_order);
 
         router::MetersPerMinutes bus_velocity = dict.at("bus_velocity").AsDouble() * 1000. / 60.;
-        transport_router.AddRoutes(bus_velocity);
+        if (previous) {
+            transport_router.AddRoutes(bus_velocity, previous->transport_router, previous->touched_stops);
+        } else {
+            transport_router.AddRoutes(bus_velocity);
+        }
     }
 
-    json::Document StatRequests(const RequestHandler& request_hand, const json::Array& requests) {
-        json::Builder json_builder;
-        json_builder.StartArray();
+    json::Document StatRequests(const RequestHandler& request_hand, const json::Array& requests,
+                                const ProcessSettings& process_settings, snapshot::CatalogueStore* catalogue_store,
+                                const memory::MemoryReport* memory_report) {
+        std::vector<request_handler::RouteInfoPtr> sorted_routes;
+        if (process_settings.sort_routes) {
+            sorted_routes = GetSortedRoutes(request_hand, requests);
+        }
+        size_t route_number = 0;
+
+        // Запросы по индексам до первого Update обслуживает request_hand с индексами из базы, после - индексы
+        // текущей версии справочника. Они строятся при первом таком запросе после каждого изменения
+        std::unique_ptr<VersionIndexes> version_indexes;
+        const auto get_index_handler = [&request_hand, catalogue_store, &version_indexes]() -> const RequestHandler& {
+            if (!catalogue_store) {
+                return request_hand;
+            }
+            const auto snapshot = catalogue_store->Read();
+            if (snapshot->GetVersion() == 0) {
+                return request_hand;
+            }
+            if (!version_indexes || version_indexes->GetVersion() != snapshot->GetVersion()) {
+                version_indexes.reset();
+                version_indexes = std::make_unique<VersionIndexes>(*snapshot, request_hand);
+            }
+            return version_indexes->GetRequestHandler();
+        };
+
+        // Ответы перемещаются в массив, а не копируются построителем: в них бывают большие строки карты
+        json::Array answers;
+        answers.reserve(requests.size());
         for (const auto& request : requests) {
             json::Node value;
             const auto& dict = request.AsDict();
             const auto found_type = dict.find("type");
             if (found_type != dict.end()) {
                 if (found_type->second.AsString() == "Bus") {
-                    value = GetBusInfo(request_hand, dict);
+                    value = catalogue_store ? GetBusInfo(*catalogue_store->Read(), dict) : GetBusInfo(request_hand, dict);
                 } else if (found_type->second.AsString() == "Stop") {
-                    value = GetStopInfo(request_hand, dict);
+                    value = catalogue_store ? GetStopInfo(*catalogue_store->Read(), dict) : GetStopInfo(request_hand, dict);
+                } else if (found_type->second.AsString() == "Update" && catalogue_store) {
+                    value = UpdateCatalogue(*catalogue_store, dict);
+                } else if (found_type->second.AsString() == "NearestStops") {
+                    value = GetNearestStopsInfo(get_index_handler(), dict);
+                } else if (found_type->second.AsString() == "Viewport") {
+                    value = GetViewportInfo(get_index_handler(), dict);
+                } else if (found_type->second.AsString() == "DirectBuses") {
+                    value = GetDirectBusesInfo(get_index_handler(), dict);
+                } else if (found_type->second.AsString() == "SearchStops") {
+                    value = GetSearchStopsInfo(get_index_handler(), dict);
+                } else if (found_type->second.AsString() == "MemoryStats" && memory_report) {
+                    value = GetMemoryStatsInfo(*memory_report, dict);
                 } else if (found_type->second.AsString() == "Map") {
                     value = GetMapInfo(request_hand, dict);
                 } else if (found_type->second.AsString() == "Route") {
-                    value = GetRouteInfo(request_hand, dict);
+                    if (process_settings.sort_routes) {
+                        value = BuildRouteInfo(sorted_routes[route_number++], dict);
+                    } else {
+                        value = GetRouteInfo(request_hand, dict);
+                    }
                 }
-                json_builder.Value(value.AsDict());
+                answers.push_back(std::move(value));
+            }
+        }
+        return json::Document{std::move(answers)};
+    }
+
+    json::Dict BuildMemoryReport(const memory::MemoryReport& memory_report) {
+        json::Array components;
+        for (const auto& [name, usage, details] : memory_report.GetComponents()) {
+            json::Dict component{
+                    {"name", name},
+                    {"bytes", ToJsonNumber(usage.bytes)},
+                    {"blocks", ToJsonNumber(usage.blocks)},
+            };
+            for (const auto& [key, value] : details) {
+                component.emplace(key, ToJsonNumber(value));
             }
+            components.emplace_back(std::move(component));
         }
-        return json::Document{json_builder.EndArray().Build()};
+        const memory::MemoryUsage total = memory::GetLiveAllocations();
+        return {
+                {"total_bytes", ToJsonNumber(total.bytes)},
+                {"total_blocks", ToJsonNumber(total.blocks)},
+                {"components", std::move(components)},
+        };
+    }
+
+    request_handler::HotRoutes HotRoutesRequest(const RequestHandler& request_hand, const TransportRouter& transport_router,
+                                                const json::Dict& dict) {
+        const auto found_query_log = dict.find("query_log");
+        if (found_query_log == dict.end()) {
+            return {};
+        }
+
+        std::map<std::pair<std::string_view, std::string_view>, int> frequencies;
+        for (const auto& query : found_query_log->second.AsArray()) {
+            const auto& query_dict = query.AsDict();
+            const std::string& from = query_dict.at("from").AsString();
+            const std::string& to = query_dict.at("to").AsString();
+            if (!transport_router.FindWaitVertex(from) || !transport_router.FindWaitVertex(to)) {
+                continue;
+            }
+            const auto found_frequency = query_dict.find("frequency");
+            const int frequency = found_frequency != query_dict.end() ? found_frequency->second.AsInt() : 1;
+            if (frequency < 0) {
+                throw std::invalid_argument("Query from " + from + " to " + to + " has negative frequency "
+                                            + std::to_string(frequency));
+            }
+            frequencies[{from, to}] += frequency;
+        }
+
+        std::vector<std::pair<std::pair<std::string_view, std::string_view>, int>> ranked(frequencies.begin(),
+                                                                                         frequencies.end());
+        std::stable_sort(ranked.begin(), ranked.end(), [](const auto& lhs, const auto& rhs) {
+            return lhs.second > rhs.second;
+        });
+        const auto found_top_count = dict.find("top_count");
+        if (found_top_count != dict.end()) {
+            const int top_count = found_top_count->second.AsInt();
+            if (top_count < 0) {
+                throw std::invalid_argument("hot_routes_settings has negative top_count " + std::to_string(top_count));
+            }
+            ranked.resize(std::min(ranked.size(), static_cast<size_t>(top_count)));
+        }
+
+        std::vector<request_handler::HotRoutes::Entry> routes;
+        routes.reserve(ranked.size());
+        for (const auto& [stops, frequency] : ranked) {
+            const auto& [from, to] = stops;
+            routes.emplace_back(request_handler::HotRoutes::Key{*transport_router.FindWaitVertex(from),
+                                                                *transport_router.FindWaitVertex(to)},
+                                request_hand.GetRouteItems(from, to));
+        }
+        return request_handler::HotRoutes{std::move(routes)};
     }
 
     void SaveBase(const TransportCatalogue& catalogue, const MapRenderer& map_renderer,
-                  const TransportRouter& transport_router, const json::Dict& dict) {
+                  const TransportRouter& transport_router, const json::Dict& dict,
+                  const json::Dict& settings, memory::MemoryReport* memory_report) {
         const auto found_file = dict.find("file");
         if (found_file == dict.end()) {
             return;
         }
-        const std::string& path = found_file->second.AsString();
-        std::ofstream out(path, std::ios::binary);
-
-        tcs::TransportCatalogue database;
-        graph::Router<router::Minutes> router(transport_router.GetGraph());
-        *database.mutable_catalogue() = std::move(proto::SaveCatalogue(catalogue));
-        *database.mutable_map_renderer() = std::move(proto::SaveMapRenderer(map_renderer));
-        *database.mutable_transport_router() = std::move(proto::SaveTransportRouter(transport_router));
-        *database.mutable_router() = std::move(proto::SaveRouter(router, transport_router.GetGraph().GetVertexCount()));
-        database.SerializeToOstream(&out);
+        memory::AllocationScope allocation_scope;
+        // В линейной модели маршруты начинаются только в вершинах остановок, их номера идут первыми
+        const auto& graph = transport_router.GetGraph();
+        graph::Router<router::Minutes> router = transport_router.GetGraphModel() == router::GraphModel::LINEAR
+                ? graph::Router<router::Minutes>(graph, transport_router.GetWaitVertexes().size())
+                : graph::Router<router::Minutes>(graph);
+        AddRouterDetails(AddToReport(memory_report, "router", allocation_scope), router, transport_router);
+
+        const RequestHandler request_hand {catalogue, map_renderer, transport_router, router};
+        const auto found_hot_routes_settings = settings.find("hot_routes_settings");
+        const auto hot_routes = found_hot_routes_settings != settings.end()
+                ? HotRoutesRequest(request_hand, transport_router, found_hot_routes_settings->second.AsDict())
+                : request_handler::HotRoutes{};
+        AddToReport(memory_report, "hot_routes", allocation_scope);
+
+        const memory::ArenaMessage<tcs::TransportCatalogue> database;
+        database->set_format_version(proto::BASE_FORMAT_VERSION);
+        proto::SaveCatalogue(catalogue, *database->mutable_catalogue());
+        proto::SaveMapRenderer(map_renderer, *database->mutable_map_renderer());
+        proto::SaveTransportRouter(transport_router, *database->mutable_transport_router());
+        proto::SaveRouter(router, transport_router.GetGraph().GetVertexCount(), *database->mutable_router());
+        proto::SaveHotRoutes(hot_routes, *database->mutable_hot_routes());
+        proto::SaveBuildSettings(settings, *database->mutable_build_settings());
+        proto::SaveStopSpatialIndex(spatial::StopSpatialIndex{catalogue}, *database->mutable_stop_index());
+        proto::SaveStopNameIndex(search::StopNameIndex{catalogue}, *database->mutable_stop_name_index());
+        AddToReport(memory_report, "protobuf", allocation_scope);
+        // Файл открывается только теперь: если настройки оказались неверными, прежняя база остаётся на диске
+        std::ofstream out(found_file->second.AsString(), std::ios::binary);
+        database->SerializeToOstream(&out);
     }
 
-    void MakeBase(TransportCatalogue& catalogue, std::istream& in_json) {
+    void MakeBase(TransportCatalogue& catalogue, std::istream& in_json, memory::MemoryReport* memory_report) {
         const auto dict = json::Load(in_json).GetRoot().AsDict();
 
+        memory::AllocationScope allocation_scope;
         const auto found_base_requests = dict.find("base_requests");
         if (found_base_requests != dict.end()) {
             BaseRequests(catalogue, found_base_requests->second.AsArray());
         }
+        AddCatalogueDetails(AddToReport(memory_report, "catalogue", allocation_scope), catalogue);
+        BuildBase(catalogue, dict, memory_report);
+    }
+
+    void UpdateBase(std::istream& in_json, memory::MemoryReport* memory_report) {
+        json::Dict dict = json::Load(in_json).GetRoot().AsDict();
+
+        const auto found_serialization_settings = dict.find("serialization_settings");
+        if (found_serialization_settings == dict.end()) {
+            return;
+        }
+        // База читается до любой записи: если её нельзя прочитать, она остаётся на диске как есть
+        const auto database = LoadBase(found_serialization_settings->second.AsDict(), true);
+        const TransportCatalogue old_catalogue = proto::LoadCatalogue(database->catalogue());
+        const MapRenderer old_map_renderer = proto::LoadMapRenderer(database->map_renderer());
+        const TransportRouter old_transport_router = proto::LoadTransportRouter(database->transport_router());
+        PreviousBase previous{old_catalogue, old_map_renderer, old_transport_router,
+                              proto::LoadBuildSettings(database->build_settings()), {}, {}, {}};
+        // Настройки, которых нет в запросе, берутся из базы
+        for (const auto& [key, section] : previous.settings) {
+            dict.emplace(key, section);
+        }
+
+        const json::Array no_changes;
+        const auto found_base_requests = dict.find("base_requests");
+        const json::Array& changes = found_base_requests != dict.end() ? found_base_requests->second.AsArray()
+                                                                      : no_changes;
+        memory::AllocationScope allocation_scope;
+        TransportCatalogue catalogue;
+        catalogue.AddBase(ApplyChanges(changes, previous));
+        AddCatalogueDetails(AddToReport(memory_report, "catalogue", allocation_scope), catalogue);
+        BuildBase(catalogue, dict, memory_report, &previous);
+    }
+
+    void BuildBase(const TransportCatalogue& catalogue, const json::Dict& dict, memory::MemoryReport* memory_report,
+                   const PreviousBase* previous) {
+        // Из прежней базы берётся только то, что построено с теми же настройками
+        const auto same_settings = [&dict, previous](const std::string& key) -> const PreviousBase* {
+            if (!previous) {
+                return nullptr;
+            }
+            const auto found_section = dict.find(key);
+            const auto found_previous_section = previous->settings.find(key);
+            return found_section != dict.end() && found_previous_section != previous->settings.end()
+                   && found_section->second == found_previous_section->second ? previous : nullptr;
+        };
 
+        memory::AllocationScope allocation_scope;
         RenderSettings settings;
         MapRenderer map_renderer;
         const auto found_render_settings = dict.find("render_settings");
         if (found_render_settings != dict.end()) {
             settings = BuildRenderSettings(found_render_settings->second.AsDict());
-            map_renderer = RenderSettingsRequests(catalogue, settings);
+            map_renderer = RenderSettingsRequests(catalogue, settings, same_settings("render_settings"));
         }
+        AddMapRendererDetails(AddToReport(memory_report, "map_renderer", allocation_scope), map_renderer);
 
-        TransportRouter transport_router(catalogue);
         const auto found_routing_settings = dict.find("routing_settings");
+        router::GraphModel graph_model = router::GraphModel::COMPLETE;
+        if (found_routing_settings != dict.end()) {
+            const auto& routing_settings = found_routing_settings->second.AsDict();
+            const auto found_graph_model = routing_settings.find("graph_model");
+            if (found_graph_model != routing_settings.end() && found_graph_model->second.AsString() == "linear") {
+                graph_model = router::GraphModel::LINEAR;
+            }
+        }
+
+        TransportRouter transport_router(catalogue, graph_model);
         if (found_routing_settings != dict.end()) {
-            RoutingSettingsRequest(transport_router, found_routing_settings->second.AsDict());
+            RoutingSettingsRequest(transport_router, found_routing_settings->second.AsDict(),
+                                   same_settings("routing_settings"));
         }
+        AddTransportRouterDetails(AddToReport(memory_report, "transport_router", allocation_scope), transport_router);
 
         const auto found_serialization_settings = dict.find("serialization_settings");
         if (found_serialization_settings != dict.end()) {
-            SaveBase(catalogue, map_renderer, transport_router, found_serialization_settings->second.AsDict());
+            SaveBase(catalogue, map_renderer, transport_router, found_serialization_settings->second.AsDict(), dict,
+                     memory_report);
         }
     }
 
-    tcs::TransportCatalogue LoadBase(const json::Dict& dict) {
+    memory::ArenaMessage<tcs::TransportCatalogue> LoadBase(const json::Dict& dict, bool is_required) {
         const auto found_file = dict.find("file");
-        tcs::TransportCatalogue database;
+        memory::ArenaMessage<tcs::TransportCatalogue> database;
         if (found_file == dict.end()) {
+            if (is_required) {
+                throw std::runtime_error("serialization_settings has no base file");
+            }
             return database;
         }
 
         const std::string& path = found_file->second.AsString();
         std::ifstream in(path, std::ios::binary);
-        database.ParseFromIstream(&in);
+        const bool is_parsed = in && database->ParseFromIstream(&in);
+        if (!is_parsed && is_required) {
+            throw std::runtime_error("Cannot read base " + path);
+        }
+        if (is_parsed && database->format_version() != proto::BASE_FORMAT_VERSION) {
+            throw std::runtime_error("Base " + path + " has format version " + std::to_string(database->format_version())
+                                     + ", expected " + std::to_string(proto::BASE_FORMAT_VERSION)
+                                     + "; rebuild it with make_base");
+        }
         return database;
     }
 
-    void ProcessRequests(std::istream& in, std::ostream& out) {
+    void ProcessRequests(std::istream& in, std::ostream& out, const ProcessSettings& process_settings) {
         const auto dict = json::Load(in).GetRoot().AsDict();
 
         const auto found_serialization_settings = dict.find("serialization_settings");
@@ -402,17 +1192,64 @@ namespace transport_catalogue::reader {
         }
 
         const auto serialization_settings = found_serialization_settings->second.AsDict();
-        tcs::TransportCatalogue database = LoadBase(serialization_settings);
-
-        const TransportCatalogue catalogue = proto::LoadCatalogue(*database.mutable_catalogue());
-        const MapRenderer map_renderer = proto::LoadMapRenderer(*database.mutable_map_renderer());
-        const TransportRouter transport_router = proto::LoadTransportRouter(database.transport_router());
-        const graph::Router<router::Minutes>& router = proto::LoadRouter(database.router(), transport_router.GetGraph());
-        const request_handler::RequestHandler request_hand { catalogue, map_renderer, transport_router, router };
+        memory::SetHugePagesMode(process_settings.huge_pages ? memory::HugePagesMode::ON
+                                                             : memory::HugePagesMode::OFF);
+        memory::SetArenaMode(process_settings.arena ? memory::ArenaMode::ON : memory::ArenaMode::OFF);
+        // Память каждой части базы замеряется при загрузке для запросов MemoryStats. Без них блоки не учитываются
         const auto found_stat_requests = dict.find("stat_requests");
+        if (found_stat_requests != dict.end() && HasMemoryStatsRequest(found_stat_requests->second.AsArray())) {
+            memory::SetAllocationCountingMode(memory::AllocationCountingMode::ON);
+        }
+        memory::MemoryReport memory_report;
+        memory::AllocationScope allocation_scope;
+        const auto database = LoadBase(serialization_settings);
+        AddToReport(&memory_report, "protobuf", allocation_scope);
+
+        const auto catalogue = std::make_shared<const TransportCatalogue>(
+                proto::LoadCatalogue(database->catalogue()));
+        AddCatalogueDetails(AddToReport(&memory_report, "catalogue", allocation_scope), *catalogue);
+        const MapRenderer map_renderer = proto::LoadMapRenderer(database->map_renderer());
+        AddMapRendererDetails(AddToReport(&memory_report, "map_renderer", allocation_scope), map_renderer);
+        const TransportRouter transport_router = proto::LoadTransportRouter(database->transport_router());
+        AddTransportRouterDetails(AddToReport(&memory_report, "transport_router", allocation_scope), transport_router);
+        const graph::Router<router::Minutes>& router = proto::LoadRouter(database->router(), transport_router.GetGraph());
+        AddRouterDetails(AddToReport(&memory_report, "router", allocation_scope), router, transport_router);
+        const request_handler::HotRoutes hot_routes = proto::LoadHotRoutes(database->hot_routes());
+        AddToReport(&memory_report, "hot_routes", allocation_scope);
+        const spatial::StopSpatialIndex stop_index = proto::LoadStopSpatialIndex(database->stop_index(), *catalogue);
+        const spatial::RouteBoundsIndex route_bounds{*catalogue};
+        AddToReport(&memory_report, "spatial_indexes", allocation_scope);
+        const connection::DirectBusesIndex direct_buses{*catalogue};
+        AddToReport(&memory_report, "direct_buses", allocation_scope);
+        const search::StopNameIndex name_index = proto::LoadStopNameIndex(database->stop_name_index(), *catalogue);
+        AddToReport(&memory_report, "stop_name_index", allocation_scope);
+        const request_handler::RequestHandler request_hand { *catalogue, map_renderer, transport_router, router,
+                                                             &hot_routes, process_settings.route_cache_size,
+                                                             &stop_index, &route_bounds, &direct_buses,
+                                                             &name_index };
+        // Запросы Bus и Stop читают текущую версию справочника, запросы Update публикуют новую, запросы
+        // по индексам остановок и маршрутов отвечают по ней же. Маршрутизатор и карта строятся по справочнику
+        // из базы и изменений не видят
+        snapshot::CatalogueStore catalogue_store(catalogue);
         if (found_stat_requests != dict.end()) {
-            const auto doc = StatRequests(request_hand, found_stat_requests->second.AsArray());
+            const auto doc = StatRequests(request_hand, found_stat_requests->second.AsArray(), process_settings,
+                                          &catalogue_store, &memory_report);
             json::Print(doc, out);
         }
+
+        if (const auto cache_stats = request_hand.GetRouteCacheStats()) {
+            std::cerr << "Route cache: hits = " << cache_stats->hits << ", misses = " << cache_stats->misses
+                      << ", size = " << cache_stats->size << "/" << cache_stats->capacity << std::endl;
+        }
+
+        if (process_settings.huge_pages) {
+            const auto stats = memory::GetHugePagesStats();
+            std::cerr << "Huge pages: explicit = " << stats.explicit_bytes << " bytes, transparent = "
+                      << stats.transparent_bytes << " bytes, regular = " << stats.regular_bytes << " bytes";
+            if (const auto anon_huge_pages = memory::GetAnonHugePagesBytes()) {
+                std::cerr << ", AnonHugePages = " << *anon_huge_pages << " bytes";
+            }
+            std::cerr << std::endl;
+        }
     }
 }
\ No newline at end of file
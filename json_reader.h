@@ -1,13 +1,18 @@
 #pragma once
 
 #include <iostream>
+#include <string_view>
+#include <unordered_set>
 
 #include <map_renderer.pb.h>
 #include <transport_catalogue.pb.h>
 
+#include "arena.h"
+#include "catalogue_snapshot.h"
 #include "graph.h"
 #include "json.h"
 #include "json_builder.h"
+#include "memory_stats.h"
 #include "request_handler.h"
 #include "transport_catalogue.h"
 #include "transport_router.h"
@@ -17,15 +22,75 @@
 namespace transport_catalogue::reader {
     namespace tcs = transport_catalogue_serialize;
 
+    // Настройки выполнения запросов process_requests
+    struct ProcessSettings {
+        // Выполнять запросы Route пакетом, отсортированным по (from, to)
+        bool sort_routes = false;
+        // Число ответов на запросы Route, хранимых в кэше. 0 - кэш отключён
+        size_t route_cache_size = 0;
+        // Размещать таблицу маршрутов и массивы графа в huge pages
+        bool huge_pages = false;
+        // Размещать разобранное сообщение базы на арене Protobuf
+        bool arena = false;
+    };
+
+    // Прежняя версия базы для make_base --update и то, чего коснулись изменения.
+    // Части новой базы, которых изменения не коснулись, берутся из прежней
+    struct PreviousBase {
+        const TransportCatalogue& catalogue;
+        const renderer::MapRenderer& map_renderer;
+        const router::TransportRouter& transport_router;
+        // Разделы настроек, с которыми построена прежняя база
+        json::Dict settings;
+        // Новые и изменённые автобусы и автобусы, у которых изменились расстояния между соседними остановками
+        // или координаты остановок: их параметры и линии на карте строятся заново
+        std::unordered_set<std::string_view> changed_buses;
+        // Остановки с изменёнными координатами
+        std::unordered_set<std::string_view> moved_stops;
+        // Прежние и новые остановки новых, изменённых и удалённых автобусов и автобусов с изменёнными расстояниями.
+        // Рёбра графа строятся заново у автобусов, проходящих через них
+        std::unordered_set<std::string_view> touched_stops;
+    };
+
     void BaseRequests(TransportCatalogue& catalogue, const json::Array& arr);
     void RenderSettingsRequests(const TransportCatalogue& catalogue, renderer::MapRenderer& map_renderer);
-    void RoutingSettingsRequest(router::TransportRouter& transport_router, const json::Dict& dict);
-    json::Document StatRequests(const request_handler::RequestHandler& request_hand, const json::Array& arr);
+    // Если previous задан, рёбра автобусов, которых не коснулись изменения, берутся из его графа
+    void RoutingSettingsRequest(router::TransportRouter& transport_router, const json::Dict& dict,
+                                const PreviousBase* previous = nullptr);
+    // Если catalogue_store задан, запросы Bus и Stop отвечаются по его текущей версии, а запросы Update её меняют.
+    // memory_report - память частей базы, которую возвращают запросы MemoryStats
+    json::Document StatRequests(const request_handler::RequestHandler& request_hand, const json::Array& arr,
+                                const ProcessSettings& process_settings = {},
+                                snapshot::CatalogueStore* catalogue_store = nullptr,
+                                const memory::MemoryReport* memory_report = nullptr);
+
+    // Бросает std::invalid_argument, если top_count или frequency запроса из query_log отрицательны
+    request_handler::HotRoutes HotRoutesRequest(const request_handler::RequestHandler& request_hand,
+                                                const router::TransportRouter& transport_router, const json::Dict& dict);
 
+    // settings - запрос make_base: из него берутся hot_routes_settings и сохраняемые в базе настройки построения.
+    // Если memory_report задан, в него добавляется память, занятая построенными частями базы
     void SaveBase(const TransportCatalogue& catalogue, const renderer::MapRenderer& map_renderer,
-                  const router::TransportRouter& transport_router, const json::Dict& dict);
-    void MakeBase(TransportCatalogue& catalogue, std::istream& in_json);
+                  const router::TransportRouter& transport_router, const json::Dict& dict,
+                  const json::Dict& settings = {}, memory::MemoryReport* memory_report = nullptr);
+    void MakeBase(TransportCatalogue& catalogue, std::istream& in_json, memory::MemoryReport* memory_report = nullptr);
+    // Применяет изменения base_requests к справочнику из существующей базы и перестраивает её.
+    // Настройки, не заданные в запросе, берутся из базы. Параметры маршрутов, примитивы карты и рёбра графа
+    // автобусов, которых изменения не коснулись, берутся из неё же.
+    // Бросает std::invalid_argument, если после изменений маршрут или расстояние ссылаются на удалённую
+    // или неизвестную остановку
+    void UpdateBase(std::istream& in_json, memory::MemoryReport* memory_report = nullptr);
+    // Строит карту, маршрутизатор и популярные маршруты справочника по настройкам из dict и сохраняет базу.
+    // previous - прежняя версия базы при make_base --update: то, что не изменилось, берётся из неё
+    void BuildBase(const TransportCatalogue& catalogue, const json::Dict& dict,
+                   memory::MemoryReport* memory_report = nullptr, const PreviousBase* previous = nullptr);
+    // Отчёт о памяти в формате ответа на запрос MemoryStats, без request_id
+    json::Dict BuildMemoryReport(const memory::MemoryReport& memory_report);
 
-    tcs::TransportCatalogue LoadBase(const json::Dict& dict);
-    void ProcessRequests(std::istream& in, std::ostream& out);
+    // Сообщение базы размещается на арене, если включён режим memory::ArenaMode::ON.
+    // Бросает std::runtime_error, если база записана в другой версии формата (proto::BASE_FORMAT_VERSION).
+    // Если is_required, бросает std::runtime_error и тогда, когда файл базы не задан, не открывается или не разбирается;
+    // иначе в этих случаях возвращает пустую базу
+    memory::ArenaMessage<tcs::TransportCatalogue> LoadBase(const json::Dict& dict, bool is_required = false);
+    void ProcessRequests(std::istream& in, std::ostream& out, const ProcessSettings& process_settings = {});
 }
\ No newline at end of file
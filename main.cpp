@@ -1,7 +1,13 @@
+#include <charconv>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
 #include <string_view>
+#include <utility>
+#include <vector>
 
 #include "json_reader.h"
 #include "log_duration.h"
@@ -12,10 +18,10 @@ using namespace std::literals;
 namespace tc = transport_catalogue;
 
 const int FIRST_TEST = 1;
-const int LAST_TEST = 12;
+const int LAST_TEST = 13;
 
 void PrintUsage(std::ostream& stream = std::cerr) {
-    stream << "Usage: transport_catalogue [make_base|process_requests]\n"sv;
+    stream << "Usage: transport_catalogue [make_base [--update] [--memory-report] [--arena]|process_requests [--sort-routes] [--route-cache=N] [--huge-pages] [--arena]|test|benchmark]\n"sv;
 }
 
 void MakeBaseTests() {
@@ -28,35 +34,127 @@ void MakeBaseTests() {
     }
 }
 
-void ProcessRequestsTests() {
+// Если ответ на пример уже есть в папке, сравнивает с ним и сообщает о расхождении, иначе записывает ответ.
+// Возвращает false, если хотя бы один ответ не совпал
+bool ProcessRequestsTests() {
+    bool is_passed = true;
     for (int i = FIRST_TEST; i < LAST_TEST + 1; ++i) {
         std::filesystem::path in_path = "input_example_process_requests"s + std::to_string(i) + ".json"s;
         std::filesystem::path out_path = "output_example_process_requests"s + std::to_string(i) + ".json"s;
         std::ifstream in(in_path);
-        std::ofstream out(out_path);
-        LOG_DURATION(in_path.filename().string());
-        tc::reader::ProcessRequests(in, out);
+        std::ostringstream out;
+        {
+            LOG_DURATION(in_path.filename().string());
+            tc::reader::ProcessRequests(in, out);
+        }
+        if (std::ifstream expected(out_path); expected) {
+            std::istringstream actual(out.str());
+            if (!(json::Load(actual) == json::Load(expected))) {
+                std::cerr << out_path.filename().string() << ": answers differ"sv << std::endl;
+                is_passed = false;
+            }
+        } else {
+            std::ofstream(out_path) << out.str();
+        }
+    }
+    return is_passed;
+}
+
+// Сравнивает время ответа на запросы при разных режимах выполнения запросов
+void ProcessRequestsBenchmark() {
+    const std::vector<std::pair<std::string, tc::reader::ProcessSettings>> modes {
+        {"request order"s, {}},
+        {"sorted routes"s, {true}},
+        {"route cache"s, {false, 1024}},
+        {"huge pages"s, {false, 0, true}},
+        {"arena"s, {false, 0, false, true}},
+    };
+    for (int i = FIRST_TEST; i < LAST_TEST + 1; ++i) {
+        std::filesystem::path in_path = "input_example_process_requests"s + std::to_string(i) + ".json"s;
+        for (const auto& [mode_name, process_settings] : modes) {
+            std::ifstream in(in_path);
+            std::ostringstream out;
+            LOG_DURATION(in_path.filename().string() + " ("s + mode_name + ")"s);
+            tc::reader::ProcessRequests(in, out, process_settings);
+        }
+    }
+}
+
+bool ParseProcessFlag(std::string_view flag, tc::reader::ProcessSettings& process_settings) {
+    const std::string_view route_cache_flag = "--route-cache="sv;
+    if (flag == "--sort-routes"sv) {
+        process_settings.sort_routes = true;
+    } else if (flag == "--huge-pages"sv) {
+        process_settings.huge_pages = true;
+    } else if (flag == "--arena"sv) {
+        process_settings.arena = true;
+    } else if (flag.substr(0, route_cache_flag.size()) == route_cache_flag) {
+        const std::string_view value = flag.substr(route_cache_flag.size());
+        const auto [end, error] = std::from_chars(value.data(), value.data() + value.size(),
+                                                  process_settings.route_cache_size);
+        return error == std::errc{} && end == value.data() + value.size();
+    } else {
+        return false;
     }
+    return true;
 }
 
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
+    if (argc < 2) {
         PrintUsage();
         return 1;
     }
 
     const std::string_view mode(argv[1]);
 
-    if (mode == "make_base"sv) {
-        tc::TransportCatalogue catalogue;
-        tc::reader::MakeBase(catalogue, std::cin);
-    } else if (mode == "process_requests"sv) {
-        tc::reader::ProcessRequests(std::cin, std::cout);
-    } else if (mode == "test") {
-        MakeBaseTests();
-        ProcessRequestsTests();
-    } else {
-        PrintUsage();
+    tc::reader::ProcessSettings process_settings;
+    bool update_base = false;
+    bool memory_report = false;
+    for (int i = 2; i < argc; ++i) {
+        const std::string_view flag(argv[i]);
+        if (mode == "make_base"sv && flag == "--update"sv) {
+            update_base = true;
+        } else if (mode == "make_base"sv && flag == "--memory-report"sv) {
+            memory_report = true;
+            memory::SetAllocationCountingMode(memory::AllocationCountingMode::ON);
+        } else if (mode == "make_base"sv && flag == "--arena"sv) {
+            memory::SetArenaMode(memory::ArenaMode::ON);
+        } else if (mode != "process_requests"sv || !ParseProcessFlag(flag, process_settings)) {
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    // Ошибки во входных данных и несовместимая база выводятся в std::cerr
+    try {
+        if (mode == "make_base"sv) {
+            memory::MemoryReport report;
+            if (update_base) {
+                tc::reader::UpdateBase(std::cin, memory_report ? &report : nullptr);
+            } else {
+                tc::TransportCatalogue catalogue;
+                tc::reader::MakeBase(catalogue, std::cin, memory_report ? &report : nullptr);
+            }
+            if (memory_report) {
+                json::Print(json::Document{tc::reader::BuildMemoryReport(report)}, std::cerr);
+                std::cerr << std::endl;
+            }
+        } else if (mode == "process_requests"sv) {
+            tc::reader::ProcessRequests(std::cin, std::cout, process_settings);
+        } else if (mode == "test") {
+            MakeBaseTests();
+            if (!ProcessRequestsTests()) {
+                return 1;
+            }
+        } else if (mode == "benchmark"sv) {
+            MakeBaseTests();
+            ProcessRequestsBenchmark();
+        } else {
+            PrintUsage();
+            return 1;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
         return 1;
     }
-}
\ No newline at end of file
+}
@@ -7,12 +7,21 @@ namespace transport_catalogue::renderer {
         return std::abs(value) < EPSILON;
     }
 
+// ---------- SphereProjector -------------------
+
+    bool SphereProjector::operator==(const SphereProjector& other) const {
+        return padding_ == other.padding_ && min_lon_ == other.min_lon_ && max_lat_ == other.max_lat_
+               && zoom_coeff_ == other.zoom_coeff_;
+    }
+
 // ---------- RouteRenderer -------------------
 
-    RouteRenderer::RouteRenderer(std::vector<svg::Point> stops_coordinates, svg::Color stroke_color, double line_width)
+    RouteRenderer::RouteRenderer(std::vector<svg::Point> stops_coordinates, svg::Color stroke_color, double line_width,
+                                 bool is_roundtrip)
         : stops_coordinates_(std::move(stops_coordinates))
         , stroke_color_(std::move(stroke_color))
-        , line_width_(line_width) {
+        , line_width_(line_width)
+        , is_roundtrip_(is_roundtrip) {
     }
 
     void RouteRenderer::Draw(svg::ObjectContainer& container) const {
@@ -31,12 +40,21 @@ namespace transport_catalogue::renderer {
         return line_width_;
     }
 
+    bool RouteRenderer::IsRoundtrip() const {
+        return is_roundtrip_;
+    }
+
     svg::Polyline RouteRenderer::CreateRoute() const {
         using namespace svg;
         Polyline polyline;
         for (const auto& coordinates : stops_coordinates_) {
             polyline.AddPoint(coordinates);
         }
+        if (!is_roundtrip_ && !stops_coordinates_.empty()) {
+            for (auto it = stops_coordinates_.rbegin() + 1; it != stops_coordinates_.rend(); ++it) {
+                polyline.AddPoint(*it);
+            }
+        }
         polyline.SetStrokeColor(stroke_color_).SetFillColor(svg::NoneColor);
         polyline.SetStrokeWidth(line_width_);
         polyline.SetStrokeLineCap(StrokeLineCap::ROUND);
@@ -61,6 +61,9 @@ namespace transport_catalogue::renderer {
                     (max_lat_ - coords.lat) * zoom_coeff_ + padding_};
         }
 
+        // Проекции совпадают, если переводят любые координаты в одни и те же точки
+        bool operator==(const SphereProjector& other) const;
+
     private:
         double padding_;
         double min_lon_ = 0.;
@@ -112,15 +115,19 @@ namespace transport_catalogue::renderer {
         std::vector<svg::Color> color_palette;
     };
 
+    // Линия маршрута. У некольцевого маршрута хранятся точки прямого направления,
+    // обратное достраивается при рисовании
     class RouteRenderer : svg::Drawable {
     public:
-        RouteRenderer(std::vector<svg::Point> stops_coordinates, svg::Color stroke_color, double line_width);
+        RouteRenderer(std::vector<svg::Point> stops_coordinates, svg::Color stroke_color, double line_width,
+                      bool is_roundtrip);
 
         void Draw(svg::ObjectContainer& container) const override;
 
         [[nodiscard]] const std::vector<svg::Point>& GetStopCoordinates() const;
         [[nodiscard]] const svg::Color& GetStrokeColor() const;
         [[nodiscard]] double GetLineWidth() const;
+        [[nodiscard]] bool IsRoundtrip() const;
 
     private:
         [[nodiscard]] svg::Polyline CreateRoute() const;
@@ -128,6 +135,7 @@ namespace transport_catalogue::renderer {
         const std::vector<svg::Point> stops_coordinates_;
         svg::Color stroke_color_;
         double line_width_;
+        bool is_roundtrip_;
     };
 
     class TextRenderer : svg::Drawable {
@@ -0,0 +1,205 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include <malloc.h>
+
+#include "huge_pages.h"
+#include "memory_stats.h"
+
+namespace memory {
+    namespace {
+        std::atomic<AllocationCountingMode> counting_mode{AllocationCountingMode::OFF};
+        std::atomic<int64_t> live_bytes{0};
+        std::atomic<int64_t> live_blocks{0};
+
+        bool IsCounting() {
+            return counting_mode.load(std::memory_order_relaxed) == AllocationCountingMode::ON;
+        }
+
+        void* CountAllocation(void* pointer) {
+            if (!IsCounting()) {
+                return pointer;
+            }
+            live_bytes.fetch_add(static_cast<int64_t>(malloc_usable_size(pointer)), std::memory_order_relaxed);
+            live_blocks.fetch_add(1, std::memory_order_relaxed);
+            return pointer;
+        }
+
+        // Выделяет блок функцией allocate, вызывая new_handler, пока блок не выделится
+        template <typename Allocate>
+        void* AllocateCounted(Allocate allocate, bool is_nothrow) {
+            while (true) {
+                if (void* pointer = allocate()) {
+                    return CountAllocation(pointer);
+                }
+                const std::new_handler handler = std::get_new_handler();
+                if (!handler) {
+                    if (is_nothrow) {
+                        return nullptr;
+                    }
+                    throw std::bad_alloc();
+                }
+                handler();
+            }
+        }
+
+        void* Allocate(size_t bytes, bool is_nothrow = false) {
+            return AllocateCounted([bytes] {
+                return std::malloc(bytes > 0 ? bytes : 1);
+            }, is_nothrow);
+        }
+
+        void* AllocateAligned(size_t bytes, std::align_val_t alignment, bool is_nothrow = false) {
+            return AllocateCounted([bytes, alignment] {
+                const auto align = static_cast<size_t>(alignment);
+                // aligned_alloc требует размер, кратный выравниванию
+                return std::aligned_alloc(align, (bytes + align - 1) / align * align);
+            }, is_nothrow);
+        }
+
+        void Deallocate(void* pointer) noexcept {
+            if (!pointer) {
+                return;
+            }
+            if (!IsCounting()) {
+                std::free(pointer);
+                return;
+            }
+            live_bytes.fetch_sub(static_cast<int64_t>(malloc_usable_size(pointer)), std::memory_order_relaxed);
+            live_blocks.fetch_sub(1, std::memory_order_relaxed);
+            std::free(pointer);
+        }
+
+        MemoryUsage Subtract(MemoryUsage lhs, MemoryUsage rhs) {
+            return {lhs.bytes - rhs.bytes, lhs.blocks - rhs.blocks};
+        }
+    }
+
+    void SetAllocationCountingMode(AllocationCountingMode mode) {
+        counting_mode.store(mode, std::memory_order_relaxed);
+    }
+
+    AllocationCountingMode GetAllocationCountingMode() {
+        return counting_mode.load(std::memory_order_relaxed);
+    }
+
+    MemoryUsage GetLiveAllocations() {
+        const HugePagesStats huge_pages = GetHugePagesStats();
+        return {live_bytes.load(std::memory_order_relaxed)
+                        + static_cast<int64_t>(huge_pages.explicit_bytes + huge_pages.transparent_bytes
+                                               + huge_pages.regular_bytes),
+                live_blocks.load(std::memory_order_relaxed) + static_cast<int64_t>(huge_pages.blocks)};
+    }
+
+    size_t GetBlockSize(const void* pointer) {
+        return pointer ? malloc_usable_size(const_cast<void*>(pointer)) : 0;
+    }
+
+    //-------- AllocationScope ---------
+
+    AllocationScope::AllocationScope()
+        : start_(GetLiveAllocations()) {
+    }
+
+    MemoryUsage AllocationScope::GetUsage() const {
+        return Subtract(GetLiveAllocations(), start_);
+    }
+
+    MemoryUsage AllocationScope::Restart() {
+        const MemoryUsage now = GetLiveAllocations();
+        const MemoryUsage usage = Subtract(now, start_);
+        start_ = now;
+        return usage;
+    }
+
+    //---------- MemoryReport ----------
+
+    MemoryReport::Component& MemoryReport::Add(std::string name, MemoryUsage usage) {
+        return components_.emplace_back(Component{std::move(name), usage, {}});
+    }
+
+    const std::vector<MemoryReport::Component>& MemoryReport::GetComponents() const {
+        return components_;
+    }
+}  // namespace memory
+
+void* operator new(size_t bytes) {
+    return memory::Allocate(bytes);
+}
+
+void* operator new[](size_t bytes) {
+    return memory::Allocate(bytes);
+}
+
+void* operator new(size_t bytes, const std::nothrow_t&) noexcept {
+    return memory::Allocate(bytes, true);
+}
+
+void* operator new[](size_t bytes, const std::nothrow_t&) noexcept {
+    return memory::Allocate(bytes, true);
+}
+
+void* operator new(size_t bytes, std::align_val_t alignment) {
+    return memory::AllocateAligned(bytes, alignment);
+}
+
+void* operator new[](size_t bytes, std::align_val_t alignment) {
+    return memory::AllocateAligned(bytes, alignment);
+}
+
+void* operator new(size_t bytes, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return memory::AllocateAligned(bytes, alignment, true);
+}
+
+void* operator new[](size_t bytes, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return memory::AllocateAligned(bytes, alignment, true);
+}
+
+void operator delete(void* pointer) noexcept {
+    memory::Deallocate(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    memory::Deallocate(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    memory::Deallocate(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept {
+    memory::Deallocate(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept {
+    memory::Deallocate(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept {
+    memory::Deallocate(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept {
+    memory::Deallocate(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t) noexcept {
+    memory::Deallocate(pointer);
+}
+
+void operator delete(void* pointer, size_t, std::align_val_t) noexcept {
+    memory::Deallocate(pointer);
+}
+
+void operator delete[](void* pointer, size_t, std::align_val_t) noexcept {
+    memory::Deallocate(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t, const std::nothrow_t&) noexcept {
+    memory::Deallocate(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t, const std::nothrow_t&) noexcept {
+    memory::Deallocate(pointer);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace memory {
+    // Учёт блоков operator new (глобальные операторы заменены в memory_stats.cpp)
+    enum class AllocationCountingMode {
+        OFF,  // operator new и delete только вызывают malloc и free
+        ON    // каждый блок учитывается в GetLiveAllocations: malloc_usable_size и два атомарных сложения
+    };
+
+    // Включается до создания замеряемых объектов и больше не выключается: блок, выделенный до включения
+    // и освобождённый после, уменьшает счётчики, хотя в них не попадал
+    void SetAllocationCountingMode(AllocationCountingMode mode);
+    [[nodiscard]] AllocationCountingMode GetAllocationCountingMode();
+
+    // Память, выделенная и ещё не освобождённая: байты по данным аллокатора и число блоков.
+    // Учитываются блоки operator new, выделенные при включённом учёте, и блоки AllocateLarge
+    struct MemoryUsage {
+        int64_t bytes = 0;
+        int64_t blocks = 0;
+    };
+
+    [[nodiscard]] MemoryUsage GetLiveAllocations();
+    // Размер блока, выделенного operator new, по данным аллокатора (malloc_usable_size). 0 для nullptr
+    [[nodiscard]] size_t GetBlockSize(const void* pointer);
+
+    // Размер блока данных вектора по данным аллокатора
+    template <typename Vector>
+    size_t GetVectorBlockSize(const Vector& vector) {
+        return vector.capacity() > 0 ? GetBlockSize(vector.data()) : 0;
+    }
+
+    // Замер памяти, которая осталась выделенной с момента создания объекта. Выделения других потоков
+    // за это время тоже попадают в замер, поэтому параллельно с замеряемым кодом ничего выполняться не должно
+    class AllocationScope {
+    public:
+        AllocationScope();
+
+        [[nodiscard]] MemoryUsage GetUsage() const;
+        // Возвращает замер и начинает новый с текущего момента
+        MemoryUsage Restart();
+
+    private:
+        MemoryUsage start_;
+    };
+
+    // Отчёт о памяти по компонентам в порядке добавления
+    class MemoryReport {
+    public:
+        struct Component {
+            std::string name;
+            MemoryUsage usage;
+            // Дополнительные показатели компонента: число элементов, размеры частей в байтах
+            std::vector<std::pair<std::string, int64_t>> details;
+        };
+
+        Component& Add(std::string name, MemoryUsage usage);
+        [[nodiscard]] const std::vector<Component>& GetComponents() const;
+
+    private:
+        std::vector<Component> components_;
+    };
+}  // namespace memory
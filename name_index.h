@@ -0,0 +1,203 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace transport_catalogue::domain {
+
+    // Перемешивание битов 64-битного значения
+    inline uint64_t MixHash(uint64_t value) {
+        value *= 0xbf58476d1ce4e5b9ULL;
+        value ^= value >> 31;
+        value *= 0x94d049bb133111ebULL;
+        return value ^ (value >> 29);
+    }
+
+    // Быстрый некриптографический хэш строки: по 8 байт за шаг с перемешиванием умножением
+    inline uint64_t HashName(std::string_view name) {
+        uint64_t hash = 0x9e3779b97f4a7c15ULL ^ name.size();
+        size_t position = 0;
+        for (; position + sizeof(uint64_t) <= name.size(); position += sizeof(uint64_t)) {
+            uint64_t word;
+            std::memcpy(&word, name.data() + position, sizeof(word));
+            hash = MixHash(hash ^ word);
+        }
+        uint64_t tail = 0;
+        if (position < name.size()) {
+            std::memcpy(&tail, name.data() + position, name.size() - position);
+        }
+        return MixHash(hash ^ tail);
+    }
+
+    // Индекс названий с открытой адресацией (Robin Hood hashing). Ячейки лежат в одном массиве и хранят
+    // хэш и длину названия, поэтому строки сравниваются только при совпадении обоих.
+    // Названия не копируются: строки должны жить дольше индекса
+    template <typename Value>
+    class NameIndex {
+    public:
+        NameIndex() = default;
+
+        // Добавляет название или заменяет значение уже добавленного
+        void Add(std::string_view name, Value value);
+
+        [[nodiscard]] const Value* Find(std::string_view name) const;
+        const Value& At(std::string_view name) const;
+        [[nodiscard]] bool Contains(std::string_view name) const;
+        // Ищет пакет названий. Ячейки всех названий запрашиваются в кэш до сравнения строк
+        [[nodiscard]] std::vector<const Value*> FindBatch(const std::vector<std::string_view>& names) const;
+        [[nodiscard]] size_t GetSize() const;
+
+    private:
+        struct Slot {
+            uint64_t hash = EMPTY;
+            const char* data = nullptr;
+            uint32_t length = 0;
+            Value value{};
+        };
+
+        // Хэш ячейки всегда ненулевой: нулём помечены пустые ячейки
+        static constexpr uint64_t EMPTY = 0;
+        static constexpr size_t MIN_CAPACITY = 16;
+        static constexpr size_t NO_POSITION = static_cast<size_t>(-1);
+
+        static uint64_t ComputeHash(std::string_view name);
+        [[nodiscard]] size_t GetDistance(size_t position, uint64_t hash) const;
+        [[nodiscard]] size_t FindPosition(std::string_view name, uint64_t hash) const;
+        [[nodiscard]] const Value* FindByHash(std::string_view name, uint64_t hash) const;
+        void Grow();
+        void Place(Slot slot);
+
+        std::vector<Slot> slots_;
+        size_t size_ = 0;
+    };
+
+    template <typename Value>
+    void NameIndex<Value>::Add(std::string_view name, Value value) {
+        const uint64_t hash = ComputeHash(name);
+        if (const size_t position = FindPosition(name, hash); position != NO_POSITION) {
+            slots_[position].value = std::move(value);
+            return;
+        }
+        if ((size_ + 1) * 4 > slots_.size() * 3) {
+            Grow();
+        }
+        Place({hash, name.data(), static_cast<uint32_t>(name.size()), std::move(value)});
+        ++size_;
+    }
+
+    template <typename Value>
+    const Value* NameIndex<Value>::Find(std::string_view name) const {
+        return FindByHash(name, ComputeHash(name));
+    }
+
+    template <typename Value>
+    const Value& NameIndex<Value>::At(std::string_view name) const {
+        const Value* value = Find(name);
+        if (!value) {
+            throw std::out_of_range("Unknown name");
+        }
+        return *value;
+    }
+
+    template <typename Value>
+    bool NameIndex<Value>::Contains(std::string_view name) const {
+        return Find(name) != nullptr;
+    }
+
+    template <typename Value>
+    std::vector<const Value*> NameIndex<Value>::FindBatch(const std::vector<std::string_view>& names) const {
+        std::vector<uint64_t> hashes;
+        hashes.reserve(names.size());
+        for (const std::string_view name : names) {
+            hashes.push_back(ComputeHash(name));
+#if defined(__GNUC__)
+            if (!slots_.empty()) {
+                __builtin_prefetch(&slots_[hashes.back() & (slots_.size() - 1)]);
+            }
+#endif
+        }
+
+        std::vector<const Value*> result;
+        result.reserve(names.size());
+        for (size_t i = 0; i < names.size(); ++i) {
+            result.push_back(FindByHash(names[i], hashes[i]));
+        }
+        return result;
+    }
+
+    template <typename Value>
+    size_t NameIndex<Value>::GetSize() const {
+        return size_;
+    }
+
+    template <typename Value>
+    uint64_t NameIndex<Value>::ComputeHash(std::string_view name) {
+        return HashName(name) | 1;
+    }
+
+    template <typename Value>
+    size_t NameIndex<Value>::GetDistance(size_t position, uint64_t hash) const {
+        return (position - hash) & (slots_.size() - 1);
+    }
+
+    template <typename Value>
+    const Value* NameIndex<Value>::FindByHash(std::string_view name, uint64_t hash) const {
+        const size_t position = FindPosition(name, hash);
+        return position != NO_POSITION ? &slots_[position].value : nullptr;
+    }
+
+    template <typename Value>
+    size_t NameIndex<Value>::FindPosition(std::string_view name, uint64_t hash) const {
+        if (slots_.empty()) {
+            return NO_POSITION;
+        }
+        const size_t mask = slots_.size() - 1;
+        // Ячейки с меньшим расстоянием от своей начальной позиции, чем пройденное, означают,
+        // что искомого названия в индексе нет
+        for (size_t distance = 0, position = hash & mask; ; ++distance, position = (position + 1) & mask) {
+            const Slot& slot = slots_[position];
+            if (slot.hash == EMPTY || GetDistance(position, slot.hash) < distance) {
+                return NO_POSITION;
+            }
+            if (slot.hash == hash && slot.length == name.size()
+                && (name.empty() || std::memcmp(slot.data, name.data(), name.size()) == 0)) {
+                return position;
+            }
+        }
+    }
+
+    template <typename Value>
+    void NameIndex<Value>::Grow() {
+        std::vector<Slot> old_slots(std::max(MIN_CAPACITY, slots_.size() * 2));
+        std::swap(slots_, old_slots);
+        for (Slot& slot : old_slots) {
+            if (slot.hash != EMPTY) {
+                Place(std::move(slot));
+            }
+        }
+    }
+
+    // Вставка Robin Hood: ячейка, ушедшая от своей позиции дальше вставляемой, не вытесняется
+    template <typename Value>
+    void NameIndex<Value>::Place(Slot slot) {
+        const size_t mask = slots_.size() - 1;
+        size_t distance = 0;
+        for (size_t position = slot.hash & mask; ; position = (position + 1) & mask, ++distance) {
+            Slot& current = slots_[position];
+            if (current.hash == EMPTY) {
+                current = std::move(slot);
+                return;
+            }
+            const size_t current_distance = GetDistance(position, current.hash);
+            if (current_distance < distance) {
+                std::swap(current, slot);
+                distance = current_distance;
+            }
+        }
+    }
+}
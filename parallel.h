@@ -0,0 +1,33 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <future>
+#include <thread>
+#include <vector>
+
+namespace parallel {
+    // Вызывает func(index) для каждого index из [0, count) в нескольких потоках.
+    // Исключение из func пробрасывается вызывающему после завершения всех потоков
+    template <typename Func>
+    void ParallelFor(size_t count, Func func) {
+        const size_t thread_count = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), count);
+        std::atomic<size_t> next_index{0};
+        std::vector<std::future<void>> workers;
+        workers.reserve(thread_count);
+        for (size_t i = 0; i < thread_count; ++i) {
+            workers.push_back(std::async(std::launch::async, [&func, &next_index, count]() {
+                for (size_t index = next_index++; index < count; index = next_index++) {
+                    func(index);
+                }
+            }));
+        }
+        for (auto& worker : workers) {
+            worker.wait();
+        }
+        for (auto& worker : workers) {
+            worker.get();
+        }
+    }
+}  // namespace parallel
@@ -0,0 +1,115 @@
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "domain.h"
+#include "name_index.h"
+#include "perfect_hash.h"
+
+namespace transport_catalogue::domain {
+    namespace {
+        // Смещение ищется перебором. Для корзин из нескольких ключей подходящее находится за единицы попыток,
+        // предел нужен лишь на случай ключей с совпадающим 64-битным хэшем
+        const uint32_t MAX_DISPLACEMENT = 1u << 24;
+    }
+
+    PerfectHash::PerfectHash(const std::vector<std::string_view>& keys, const std::vector<uint32_t>& values) {
+        std::unordered_map<std::string_view, uint32_t> unique_keys;
+        std::vector<std::string_view> ordered_keys;
+        for (size_t i = 0; i < keys.size(); ++i) {
+            const auto [position, inserted] = unique_keys.insert_or_assign(keys[i], values[i]);
+            if (inserted) {
+                ordered_keys.push_back(keys[i]);
+            }
+        }
+        const size_t key_count = ordered_keys.size();
+        if (key_count == 0) {
+            return;
+        }
+
+        displacements_.assign((key_count + BUCKET_SIZE - 1) / BUCKET_SIZE, 0);
+        values_.assign(key_count, NO_ID);
+
+        std::vector<uint64_t> hashes;
+        std::vector<std::vector<size_t>> buckets(displacements_.size());
+        hashes.reserve(key_count);
+        for (size_t i = 0; i < key_count; ++i) {
+            hashes.push_back(HashName(ordered_keys[i]));
+            buckets[GetBucket(hashes.back())].push_back(i);
+        }
+
+        // Большие корзины размещаются первыми, пока свободных ячеек много
+        std::vector<size_t> bucket_order(buckets.size());
+        std::iota(bucket_order.begin(), bucket_order.end(), 0);
+        std::stable_sort(bucket_order.begin(), bucket_order.end(), [&buckets](size_t lhs, size_t rhs) {
+            return buckets[lhs].size() > buckets[rhs].size();
+        });
+
+        std::vector<bool> is_taken(key_count, false);
+        std::vector<size_t> positions;
+        for (const size_t bucket : bucket_order) {
+            const auto& bucket_keys = buckets[bucket];
+            if (bucket_keys.empty()) {
+                break;
+            }
+            uint32_t displacement = 0;
+            for (; displacement < MAX_DISPLACEMENT; ++displacement) {
+                positions.clear();
+                for (const size_t key : bucket_keys) {
+                    const size_t position = GetPosition(hashes[key], displacement);
+                    if (is_taken[position]
+                        || std::find(positions.begin(), positions.end(), position) != positions.end()) {
+                        break;
+                    }
+                    positions.push_back(position);
+                }
+                if (positions.size() == bucket_keys.size()) {
+                    break;
+                }
+            }
+            if (displacement == MAX_DISPLACEMENT) {
+                throw std::runtime_error("Cannot build perfect hash for names");
+            }
+
+            displacements_[bucket] = displacement;
+            for (size_t i = 0; i < bucket_keys.size(); ++i) {
+                is_taken[positions[i]] = true;
+                values_[positions[i]] = unique_keys.at(ordered_keys[bucket_keys[i]]);
+            }
+        }
+    }
+
+    PerfectHash::PerfectHash(std::vector<uint32_t> displacements, std::vector<uint32_t> values)
+        : displacements_(std::move(displacements))
+        , values_(std::move(values)) {
+    }
+
+    uint32_t PerfectHash::Find(std::string_view key) const {
+        if (IsEmpty()) {
+            return NO_ID;
+        }
+        const uint64_t hash = HashName(key);
+        return values_[GetPosition(hash, displacements_[GetBucket(hash)])];
+    }
+
+    bool PerfectHash::IsEmpty() const {
+        return values_.empty() || displacements_.empty();
+    }
+
+    const std::vector<uint32_t>& PerfectHash::GetDisplacements() const {
+        return displacements_;
+    }
+
+    const std::vector<uint32_t>& PerfectHash::GetValues() const {
+        return values_;
+    }
+
+    size_t PerfectHash::GetBucket(uint64_t hash) const {
+        return (hash >> 32) % displacements_.size();
+    }
+
+    size_t PerfectHash::GetPosition(uint64_t hash, uint32_t displacement) const {
+        return MixHash(hash + displacement * 0x9e3779b97f4a7c15ULL) % values_.size();
+    }
+}
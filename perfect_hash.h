@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace transport_catalogue::domain {
+
+    // Минимальный совершенный хэш (схема CHD, hash and displace) для неизменного набора названий.
+    // Ключи раскладываются по корзинам, и для каждой корзины подбирается смещение, при котором все её ключи
+    // попадают в свободные ячейки. Каждый ключ набора получает свою ячейку из [0, числа ключей),
+    // в которой хранится его значение. Для названия не из набора возвращается значение чужой ячейки,
+    // поэтому найденное значение нужно проверить сравнением названий
+    class PerfectHash {
+    public:
+        PerfectHash() = default;
+        // Строит хэш для ключей keys со значениями values. При повторе ключа остаётся последнее значение
+        PerfectHash(const std::vector<std::string_view>& keys, const std::vector<uint32_t>& values);
+        // Восстанавливает хэш из сохранённых смещений и значений
+        PerfectHash(std::vector<uint32_t> displacements, std::vector<uint32_t> values);
+
+        // Значение единственной ячейки, в которой может лежать key. NO_ID, если хэш пуст
+        [[nodiscard]] uint32_t Find(std::string_view key) const;
+        [[nodiscard]] bool IsEmpty() const;
+
+        const std::vector<uint32_t>& GetDisplacements() const;
+        const std::vector<uint32_t>& GetValues() const;
+
+    private:
+        // Среднее число ключей в корзине
+        static const size_t BUCKET_SIZE = 4;
+
+        [[nodiscard]] size_t GetBucket(uint64_t hash) const;
+        [[nodiscard]] size_t GetPosition(uint64_t hash, uint32_t displacement) const;
+
+        std::vector<uint32_t> displacements_;
+        std::vector<uint32_t> values_;
+    };
+}
@@ -22,6 +22,12 @@ namespace ranges {
         It end() const {
             return end_;
         }
+        [[nodiscard]] bool empty() const {
+            return begin_ == end_;
+        }
+        [[nodiscard]] size_t size() const {
+            return std::distance(begin_, end_);
+        }
 
     private:
         It begin_;
@@ -1,59 +1,326 @@
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
 #include "request_handler.h"
 #include "json_builder.h"
 
 namespace transport_catalogue::request_handler {
 
-    using BusPtr = std::string_view;
+    //----------- RouteCache -----------
+
+    size_t RouteCache::KeyHash::operator()(const Key& key) const {
+        std::hash<graph::VertexId> hasher;
+        return hasher(key.first) + 37 * hasher(key.second);
+    }
+
+    RouteCache::RouteCache(size_t capacity)
+        : capacity_(capacity) {
+    }
+
+    std::optional<RouteInfoPtr> RouteCache::Find(const Key& key) {
+        std::lock_guard guard(mutex_);
+        const auto found = index_.find(key);
+        if (found == index_.end()) {
+            ++misses_;
+            return std::nullopt;
+        }
+        ++hits_;
+        entries_.splice(entries_.begin(), entries_, found->second);
+        return found->second->second;
+    }
+
+    void RouteCache::Add(const Key& key, RouteInfoPtr route_info) {
+        if (capacity_ == 0) {
+            return;
+        }
+        std::lock_guard guard(mutex_);
+        if (const auto found = index_.find(key); found != index_.end()) {
+            found->second->second = std::move(route_info);
+            entries_.splice(entries_.begin(), entries_, found->second);
+            return;
+        }
+        if (entries_.size() == capacity_) {
+            index_.erase(entries_.back().first);
+            entries_.pop_back();
+        }
+        entries_.emplace_front(key, std::move(route_info));
+        index_.emplace(key, entries_.begin());
+    }
+
+    RouteCacheStats RouteCache::GetStats() const {
+        std::lock_guard guard(mutex_);
+        return {hits_, misses_, entries_.size(), capacity_};
+    }
+
+    RouteInfo PrintRouteItems(RouteItems route_items) {
+        json::Builder builder;
+        builder.StartArray();
+        for (auto& item : route_items.items) {
+            if (item.type == router::ItemType::WAIT) {
+                builder.StartDict().Key("type").Value("Wait").Key("stop_name").Value(std::move(item.name));
+            } else {
+                builder.StartDict().Key("type").Value("Bus").Key("bus").Value(std::move(item.name));
+                builder.Key("span_count").Value(item.span_count);
+            }
+            builder.Key("time").Value(item.time).EndDict();
+        }
+        return {json::PrintToText(builder.EndArray().Build()), route_items.total_time};
+    }
+
+    //----------- HotRoutes ------------
+
+    HotRoutes::Entry::Entry(Key key, std::optional<RouteItems> route)
+        : key(key)
+        , route(std::move(route))
+        , route_info(this->route ? std::make_shared<const RouteInfo>(PrintRouteItems(*this->route)) : nullptr) {
+    }
+
+    HotRoutes::HotRoutes(std::vector<Entry> routes)
+        : routes_(std::move(routes)) {
+        std::sort(routes_.begin(), routes_.end(), [](const Entry& lhs, const Entry& rhs) {
+            return lhs.key < rhs.key;
+        });
+    }
+
+    std::optional<RouteInfoPtr> HotRoutes::Find(const Key& key) const {
+        const auto found = std::lower_bound(routes_.begin(), routes_.end(), key, [](const Entry& entry, const Key& key) {
+            return entry.key < key;
+        });
+        if (found == routes_.end() || found->key != key) {
+            return std::nullopt;
+        }
+        return found->route_info;
+    }
+
+    const std::vector<HotRoutes::Entry>& HotRoutes::GetRoutes() const {
+        return routes_;
+    }
+
+    //---------- RequestHandler ----------
 
     RequestHandler::RequestHandler(const TransportCatalogue& catalogue, const MapRenderer& renderer,
-                                   const TransportRouter& transport_router, const graph::Router<router::Minutes>& router)
+                                   const TransportRouter& transport_router, const graph::Router<router::Minutes>& router,
+                                   const HotRoutes* hot_routes, size_t route_cache_capacity,
+                                   const spatial::StopSpatialIndex* stop_index,
+                                   const spatial::RouteBoundsIndex* route_bounds,
+                                   const connection::DirectBusesIndex* direct_buses,
+                                   const search::StopNameIndex* name_index)
         : db_(catalogue)
         , renderer_(renderer)
         , tr_(transport_router)
-        , router_(router) {
+        , router_(router)
+        , hot_routes_(hot_routes)
+        , stop_index_(stop_index)
+        , route_bounds_(route_bounds)
+        , direct_buses_(direct_buses)
+        , name_index_(name_index) {
+        if (route_cache_capacity > 0) {
+            route_cache_ = std::make_unique<RouteCache>(route_cache_capacity);
+        }
     }
 
-    domain::Bus* RequestHandler::GetBusStat(std::string_view bus_name) const {
+    RequestHandler RequestHandler::WithCatalogue(const TransportCatalogue& catalogue,
+                                                 const spatial::StopSpatialIndex* stop_index,
+                                                 const spatial::RouteBoundsIndex* route_bounds,
+                                                 const connection::DirectBusesIndex* direct_buses,
+                                                 const search::StopNameIndex* name_index) const {
+        return RequestHandler(catalogue, renderer_, tr_, router_, hot_routes_, 0, stop_index, route_bounds,
+                              direct_buses, name_index);
+    }
+
+    const domain::Bus* RequestHandler::GetBusStat(std::string_view bus_name) const {
         return db_.FindRoute(bus_name);
     }
 
-    const std::set<BusPtr>* RequestHandler::GetBusesByStop(std::string_view stop_name) const {
-        domain::Stop* pointer_to_stop = db_.FindStop(stop_name);
-        if (!pointer_to_stop) {
-            return nullptr;
-        } else {
-            return &db_.FindBusesAtStops(stop_name);
+    std::optional<TransportCatalogue::BusIdRange> RequestHandler::GetBusesByStop(std::string_view stop_name) const {
+        const domain::StopId stop_id = db_.FindStopId(stop_name);
+        if (stop_id == domain::NO_ID) {
+            return std::nullopt;
+        }
+        return db_.GetBusesAtStop(stop_id);
+    }
+
+    std::string_view RequestHandler::GetBusName(domain::BusId bus_id) const {
+        return db_.GetBus(bus_id).number;
+    }
+
+    std::string_view RequestHandler::GetStopName(domain::StopId stop_id) const {
+        return db_.GetStop(stop_id).name;
+    }
+
+    std::vector<RequestHandler::Neighbour> RequestHandler::GetNearestStops(geo::Coordinates point, size_t count,
+                                                                           std::optional<double> radius) const {
+        if (!stop_index_) {
+            return {};
         }
+        return radius ? stop_index_->FindWithinRadius(point, *radius, count) : stop_index_->FindNearest(point, count);
+    }
+
+    std::vector<domain::StopId> RequestHandler::GetStopsInBox(const spatial::GeoBox& box) const {
+        if (!stop_index_) {
+            return {};
+        }
+        std::vector<domain::StopId> stops = stop_index_->FindInBox(box);
+        std::sort(stops.begin(), stops.end(), [this](domain::StopId lhs, domain::StopId rhs) {
+            return db_.GetStop(lhs).name < db_.GetStop(rhs).name;
+        });
+        return stops;
+    }
+
+    std::vector<domain::BusId> RequestHandler::GetBusesInBox(const spatial::GeoBox& box) const {
+        if (!route_bounds_) {
+            return {};
+        }
+        std::vector<domain::BusId> buses = route_bounds_->FindCrossing(box);
+        std::sort(buses.begin(), buses.end(), [this](domain::BusId lhs, domain::BusId rhs) {
+            return db_.GetBus(lhs).number < db_.GetBus(rhs).number;
+        });
+        return buses;
+    }
+
+    std::optional<std::vector<connection::DirectBus>> RequestHandler::GetDirectBuses(std::string_view from_stop,
+                                                                                     std::string_view to_stop) const {
+        const domain::StopId from_id = db_.FindStopId(from_stop);
+        const domain::StopId to_id = db_.FindStopId(to_stop);
+        if (from_id == domain::NO_ID || to_id == domain::NO_ID) {
+            return std::nullopt;
+        }
+        if (!direct_buses_) {
+            return std::vector<connection::DirectBus>{};
+        }
+        return direct_buses_->Find(from_id, to_id);
+    }
+
+    std::vector<search::FoundStop> RequestHandler::SearchStops(std::string_view query, size_t count,
+                                                               std::optional<size_t> max_distance) const {
+        if (!name_index_) {
+            return {};
+        }
+        return max_distance ? name_index_->FindSimilar(query, *max_distance, count)
+                            : name_index_->FindByPrefix(query, count);
     }
 
     svg::Document RequestHandler::RenderMap() const {
         return renderer_.Render();
     }
 
-    std::optional<RouteInfo> RequestHandler::GetItems(std::string_view from_stop, std::string_view to_stop) const {
-        auto route_info = router_.BuildRoute(tr_.GetWaitIndexes().at(from_stop), tr_.GetWaitIndexes().at(to_stop));
+    RouteInfoPtr RequestHandler::GetItems(std::string_view from_stop, std::string_view to_stop) const {
+        return GetCachedItems(GetWaitVertex(from_stop), GetWaitVertex(to_stop));
+    }
+
+    std::optional<RouteItems> RequestHandler::GetRouteItems(std::string_view from_stop, std::string_view to_stop) const {
+        return BuildRouteItems(GetWaitVertex(from_stop), GetWaitVertex(to_stop));
+    }
+
+    std::vector<RouteInfoPtr> RequestHandler::GetItemsSorted(const std::vector<StopsPair>& routes) const {
+        std::vector<std::pair<graph::VertexId, graph::VertexId>> vertexes;
+        vertexes.reserve(routes.size());
+        for (const auto& [from_stop, to_stop] : routes) {
+            vertexes.emplace_back(GetWaitVertex(from_stop), GetWaitVertex(to_stop));
+        }
+
+        std::vector<size_t> order(routes.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&vertexes](size_t lhs, size_t rhs) {
+            return vertexes[lhs] < vertexes[rhs];
+        });
+
+        std::vector<RouteInfoPtr> result(routes.size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            const auto& [from, to] = vertexes[order[i]];
+            if (i > 0 && vertexes[order[i - 1]] == vertexes[order[i]]) {
+                result[order[i]] = result[order[i - 1]];
+            } else {
+                result[order[i]] = GetCachedItems(from, to);
+            }
+        }
+        return result;
+    }
+
+    std::optional<RouteCacheStats> RequestHandler::GetRouteCacheStats() const {
+        if (!route_cache_) {
+            return std::nullopt;
+        }
+        return route_cache_->GetStats();
+    }
+
+    graph::VertexId RequestHandler::GetWaitVertex(std::string_view stop_name) const {
+        const auto vertex = tr_.FindWaitVertex(stop_name);
+        if (!vertex) {
+            throw std::out_of_range("Unknown stop");
+        }
+        return *vertex;
+    }
+
+    RouteInfoPtr RequestHandler::GetCachedItems(graph::VertexId from, graph::VertexId to) const {
+        if (hot_routes_) {
+            if (auto hot_route = hot_routes_->Find({from, to})) {
+                return std::move(*hot_route);
+            }
+        }
+        if (!route_cache_) {
+            return BuildItems(from, to);
+        }
+        if (auto cached = route_cache_->Find({from, to})) {
+            return std::move(*cached);
+        }
+        RouteInfoPtr result = BuildItems(from, to);
+        route_cache_->Add({from, to}, result);
+        return result;
+    }
+
+    RouteInfoPtr RequestHandler::BuildItems(graph::VertexId from, graph::VertexId to) const {
+        auto route_items = BuildRouteItems(from, to);
+        if (!route_items) {
+            return nullptr;
+        }
+        return std::make_shared<const RouteInfo>(PrintRouteItems(std::move(*route_items)));
+    }
+
+    std::optional<RouteItems> RequestHandler::BuildRouteItems(graph::VertexId from, graph::VertexId to) const {
+        auto route_info = router_.BuildRoute(from, to);
         if (!route_info) {
             return std::nullopt;
         }
-        router::Minutes total_time = 0.;
-        json::Builder builder;
-        builder.StartArray();
+        RouteItems result;
         const auto& items = tr_.GetItems();
+
+        // Подряд идущие рёбра поездки (в линейной модели графа - по одному на перегон)
+        // объединяются в один элемент Bus
+        std::optional<router::Item> bus_item;
+        int bus_span_count = 0;
+        router::Minutes bus_time = 0.;
+        const auto add_bus_item = [this, &result, &bus_item, &bus_span_count, &bus_time]() {
+            if (bus_item) {
+                result.items.push_back({router::ItemType::BUS, std::string{tr_.GetItemName(*bus_item)}, bus_span_count,
+                                        bus_time});
+                bus_item.reset();
+            }
+        };
+
         for (const auto edge_id : route_info->edges) {
-            builder.StartDict();
             const auto& [from, to, weight] = tr_.GetGraph().GetEdge(edge_id);
-            total_time += weight;
-            builder.Key("type");
+            result.total_time += weight;
             const router::Item& item = items.at(edge_id);
+            if (item.type == router::ItemType::BUS) {
+                if (bus_item) {
+                    bus_span_count += item.span_count;
+                    bus_time += weight;
+                } else {
+                    bus_item = item;
+                    bus_span_count = item.span_count;
+                    bus_time = weight;
+                }
+                continue;
+            }
+
+            add_bus_item();
             if (item.type == router::ItemType::WAIT) {
-                builder.Value("Wait").Key("stop_name").Value(std::string{item.name});
-            } else {
-                builder.Value("Bus").Key("bus").Value(std::string{item.name});
-                builder.Key("span_count").Value(item.span_count);
+                result.items.push_back({router::ItemType::WAIT, std::string{tr_.GetItemName(item)}, 0, weight});
             }
-            builder.Key("time").Value(weight);
-            builder.EndDict();
         }
-        return RouteInfo{builder.EndArray().Build().AsArray(), total_time};
+        add_bus_item();
+        return result;
     }
-}
\ No newline at end of file
+}
@@ -1,43 +1,191 @@
 #pragma once
 
+#include <list>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <string_view>
+#include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
+#include "direct_buses.h"
 #include "domain.h"
 #include "graph.h"
 #include "json.h"
 #include "map_renderer.h"
 #include "router.h"
+#include "spatial_index.h"
+#include "stop_search.h"
 #include "transport_catalogue.h"
 #include "transport_router.h"
 
 namespace transport_catalogue::request_handler {
 
+    // Элементы маршрута хранятся выведенными в текст: ответ из кэша или из популярных маршрутов
+    // выводится без построения и копирования узлов JSON
     struct RouteInfo {
-        json::Array items;
+        json::Printed items;
         router::Minutes total_time;
     };
 
+    // Готовый ответ на запрос Route. nullptr - маршрут не найден
+    using RouteInfoPtr = std::shared_ptr<const RouteInfo>;
+
+    // Элемент ответа на запрос Route: ожидание на остановке name (WAIT) или поездка на автобусе name
+    // через span_count остановок (BUS)
+    struct RouteItem {
+        router::ItemType type = router::ItemType::WAIT;
+        std::string name;
+        int span_count = 0;
+        router::Minutes time = 0.;
+    };
+
+    // Маршрут по элементам, из которого выводится RouteInfo
+    struct RouteItems {
+        std::vector<RouteItem> items;
+        router::Minutes total_time = 0.;
+    };
+
+    [[nodiscard]] RouteInfo PrintRouteItems(RouteItems route_items);
+
+    struct RouteCacheStats {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t size = 0;
+        size_t capacity = 0;
+    };
+
+    // Потокобезопасный LRU-кэш готовых ответов на запросы Route по паре вершин (from, to)
+    class RouteCache {
+    public:
+        using Key = std::pair<graph::VertexId, graph::VertexId>;
+
+        explicit RouteCache(size_t capacity);
+
+        std::optional<RouteInfoPtr> Find(const Key& key);
+        void Add(const Key& key, RouteInfoPtr route_info);
+
+        [[nodiscard]] RouteCacheStats GetStats() const;
+
+    private:
+        struct KeyHash {
+            size_t operator()(const Key& key) const;
+        };
+        using Entry = std::pair<Key, RouteInfoPtr>;
+
+        const size_t capacity_;
+        std::list<Entry> entries_;
+        std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index_;
+        mutable std::mutex mutex_;
+        size_t hits_ = 0;
+        size_t misses_ = 0;
+    };
+
+    // Заранее построенные ответы на популярные запросы Route, хранимые в базе.
+    // Плоский массив, отсортированный по паре вершин (from, to)
+    class HotRoutes {
+    public:
+        using Key = RouteCache::Key;
+        // Элементы маршрута сохраняются в базе, ответ выводится из них один раз при создании записи.
+        // Если маршрут не найден, route - nullopt, а route_info - nullptr
+        struct Entry {
+            Entry(Key key, std::optional<RouteItems> route);
+
+            Key key;
+            std::optional<RouteItems> route;
+            RouteInfoPtr route_info;
+        };
+
+        HotRoutes() = default;
+        explicit HotRoutes(std::vector<Entry> routes);
+
+        [[nodiscard]] std::optional<RouteInfoPtr> Find(const Key& key) const;
+        [[nodiscard]] const std::vector<Entry>& GetRoutes() const;
+
+    private:
+        std::vector<Entry> routes_;
+    };
+
     class RequestHandler {
     public:
-        using BusPtr = std::string_view;
         using TransportCatalogue = transport_catalogue::TransportCatalogue;
         using MapRenderer = renderer::MapRenderer;
         using TransportRouter = router::TransportRouter;
+        using StopsPair = std::pair<std::string_view, std::string_view>;
 
+        using Neighbour = spatial::StopSpatialIndex::Neighbour;
+
+        // hot_routes - готовые ответы на популярные запросы Route, проверяются до обращения к маршрутизатору.
+        // route_cache_capacity - число ответов на запросы Route, хранимых в кэше. 0 - кэш отключён.
+        // stop_index и route_bounds - индексы для запросов остановок и маршрутов по месту на карте,
+        // direct_buses - индекс автобусов без пересадок, name_index - индекс поиска остановок по названию;
+        // без индексов эти запросы ничего не находят
         RequestHandler(const TransportCatalogue& catalogue, const MapRenderer& renderer,
-                       const TransportRouter& transport_router, const graph::Router<router::Minutes>& router);
+                       const TransportRouter& transport_router, const graph::Router<router::Minutes>& router,
+                       const HotRoutes* hot_routes = nullptr, size_t route_cache_capacity = 0,
+                       const spatial::StopSpatialIndex* stop_index = nullptr,
+                       const spatial::RouteBoundsIndex* route_bounds = nullptr,
+                       const connection::DirectBusesIndex* direct_buses = nullptr,
+                       const search::StopNameIndex* name_index = nullptr);
+
+        // Обработчик с другим справочником и индексами к нему, без кэша маршрутов. Карта и маршрутизатор
+        // остаются прежними, поэтому запросы Map и Route к нему по-прежнему отвечают по исходному справочнику
+        [[nodiscard]] RequestHandler WithCatalogue(const TransportCatalogue& catalogue,
+                                                   const spatial::StopSpatialIndex* stop_index,
+                                                   const spatial::RouteBoundsIndex* route_bounds,
+                                                   const connection::DirectBusesIndex* direct_buses,
+                                                   const search::StopNameIndex* name_index) const;
 
-        [[nodiscard]] domain::Bus* GetBusStat(std::string_view bus_name) const;
-        [[nodiscard]] const std::set<BusPtr>* GetBusesByStop(std::string_view stop_name) const;
+        [[nodiscard]] const domain::Bus* GetBusStat(std::string_view bus_name) const;
+        // Номера автобусов, проходящих через остановку, по возрастанию названий. nullopt, если остановки нет
+        [[nodiscard]] std::optional<TransportCatalogue::BusIdRange> GetBusesByStop(std::string_view stop_name) const;
+        [[nodiscard]] std::string_view GetBusName(domain::BusId bus_id) const;
+        [[nodiscard]] std::string_view GetStopName(domain::StopId stop_id) const;
+        // Ближайшие к точке остановки: count ближайших или, если задан radius, все в пределах radius метров
+        // (не больше count). По возрастанию расстояния
+        [[nodiscard]] std::vector<Neighbour> GetNearestStops(geo::Coordinates point, size_t count,
+                                                             std::optional<double> radius = std::nullopt) const;
+        // Остановки внутри прямоугольника по возрастанию названий
+        [[nodiscard]] std::vector<domain::StopId> GetStopsInBox(const spatial::GeoBox& box) const;
+        // Автобусы, маршрут которых проходит через прямоугольник, по возрастанию названий
+        [[nodiscard]] std::vector<domain::BusId> GetBusesInBox(const spatial::GeoBox& box) const;
+        // Автобусы, на которых можно доехать от остановки до остановки без пересадок, по возрастанию названий.
+        // nullopt, если одной из остановок нет
+        [[nodiscard]] std::optional<std::vector<connection::DirectBus>> GetDirectBuses(std::string_view from_stop,
+                                                                                       std::string_view to_stop) const;
+        // Не больше count остановок, название которых начинается с query или, если max_distance задано, отличается
+        // от query не больше чем на max_distance символов. По убыванию числа автобусов, затем по названиям
+        [[nodiscard]] std::vector<search::FoundStop> SearchStops(std::string_view query, size_t count,
+                                                                 std::optional<size_t> max_distance = std::nullopt) const;
         [[nodiscard]] svg::Document RenderMap() const;
-        [[nodiscard]] std::optional<RouteInfo> GetItems(std::string_view from_stop, std::string_view to_stop) const;
+        [[nodiscard]] RouteInfoPtr GetItems(std::string_view from_stop, std::string_view to_stop) const;
+        // Маршрут по элементам, построенный маршрутизатором в обход кэша и популярных маршрутов.
+        // nullopt - маршрут не найден
+        [[nodiscard]] std::optional<RouteItems> GetRouteItems(std::string_view from_stop, std::string_view to_stop) const;
+
+        // Строит маршруты пакетом: запросы выполняются в порядке (from, to), чтобы обращения
+        // к таблице маршрутизатора шли по строкам подряд, а ответы возвращаются в исходном порядке
+        [[nodiscard]] std::vector<RouteInfoPtr> GetItemsSorted(const std::vector<StopsPair>& routes) const;
+
+        [[nodiscard]] std::optional<RouteCacheStats> GetRouteCacheStats() const;
 
     private:
+        [[nodiscard]] graph::VertexId GetWaitVertex(std::string_view stop_name) const;
+        [[nodiscard]] RouteInfoPtr GetCachedItems(graph::VertexId from, graph::VertexId to) const;
+        [[nodiscard]] RouteInfoPtr BuildItems(graph::VertexId from, graph::VertexId to) const;
+        [[nodiscard]] std::optional<RouteItems> BuildRouteItems(graph::VertexId from, graph::VertexId to) const;
+
         const TransportCatalogue& db_;
         const MapRenderer& renderer_;
         const TransportRouter& tr_;
         const graph::Router<router::Minutes>& router_;
+        const HotRoutes* hot_routes_;
+        const spatial::StopSpatialIndex* stop_index_;
+        const spatial::RouteBoundsIndex* route_bounds_;
+        const connection::DirectBusesIndex* direct_buses_;
+        const search::StopNameIndex* name_index_;
+        mutable std::unique_ptr<RouteCache> route_cache_;
     };
 }
@@ -5,12 +5,14 @@
 #include <cstdint>
 #include <iterator>
 #include <optional>
+#include <queue>
 #include <stdexcept>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "graph.h"
+#include "huge_pages.h"
 
 namespace graph {
     template <typename Weight>
@@ -22,11 +24,15 @@ namespace graph {
     private:
         friend RouterCreatorHelper<Weight>;
 
-        using Graph = DirectedWeightedGraph<Weight>;
+        using Graph = FrozenGraph<Weight>;
         struct RouteInternalData;
 
     public:
+        // Строит маршруты между всеми парами вершин алгоритмом Флойда-Уоршелла
         explicit Router(const Graph& graph);
+        // Строит маршруты только из вершин [0, source_count) поиском Дейкстры из каждой из них.
+        // Подходит для графов, в которых маршруты начинаются лишь в небольшой части вершин
+        Router(const Graph& graph, size_t source_count);
 
         struct RouteInfo {
             Weight weight;
@@ -35,37 +41,48 @@ namespace graph {
 
         std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
         const std::optional<RouteInternalData>& GetData(VertexId from, VertexId to) const;
+        [[nodiscard]] size_t GetSourceCount() const;
 
     private:
         struct RouteInternalData {
             Weight weight;
             std::optional<EdgeId> prev_edge;
         };
-        using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>;
+        // Таблица маршрутов хранится одним блоком по строкам: маршрут from -> to лежит в позиции
+        // from * vertex_count_ + to
+        using RoutesInternalData = std::vector<std::optional<RouteInternalData>,
+                                               memory::HugePageAllocator<std::optional<RouteInternalData>>>;
 
-        Router(const Graph& graph, VertexId vertex_count);
+        Router(const Graph& graph, size_t source_count, size_t vertex_count);
 
         void InitializeRoutesInternalData(const Graph& graph);
 
+        void BuildRoutesFromSource(const Graph& graph, VertexId source);
+
         void RelaxRoute(VertexId vertex_from, VertexId vertex_to, const RouteInternalData& route_from,
                         const RouteInternalData& route_to);
 
         void RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through);
 
+        std::optional<RouteInternalData>& GetRoute(VertexId from, VertexId to);
+        const std::optional<RouteInternalData>& GetRoute(VertexId from, VertexId to) const;
+
         static constexpr Weight ZERO_WEIGHT{};
         const Graph& graph_;
+        size_t source_count_;
+        size_t vertex_count_;
         RoutesInternalData routes_internal_data_;
     };
 
     template <typename Weight>
     class RouterCreatorHelper {
     private:
-        using Graph = DirectedWeightedGraph<Weight>;
+        using Graph = FrozenGraph<Weight>;
 
     public:
         using RouteInternalData = typename Router<Weight>::RouteInternalData;
 
-        explicit RouterCreatorHelper(const Graph& graph);
+        RouterCreatorHelper(const Graph& graph, size_t source_count);
 
         Router<Weight>&& BuildRouter();
         void AddData(VertexId from, VertexId to, std::optional<RouteInternalData>&& data);
@@ -79,9 +96,7 @@ namespace graph {
 
     template <typename Weight>
     Router<Weight>::Router(const Graph& graph)
-            : graph_(graph)
-            , routes_internal_data_(graph.GetVertexCount(),
-                                    std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount()))
+            : Router(graph, graph.GetVertexCount(), graph.GetVertexCount())
     {
         InitializeRoutesInternalData(graph);
 
@@ -91,10 +106,19 @@ namespace graph {
         }
     }
 
+    template <typename Weight>
+    Router<Weight>::Router(const Graph& graph, size_t source_count)
+            : Router(graph, source_count, graph.GetVertexCount())
+    {
+        for (VertexId source = 0; source < source_count; ++source) {
+            BuildRoutesFromSource(graph, source);
+        }
+    }
+
     template <typename Weight>
     std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
                                                                                  VertexId to) const {
-        const auto& route_internal_data = routes_internal_data_.at(from).at(to);
+        const auto& route_internal_data = GetData(from, to);
         if (!route_internal_data) {
             return std::nullopt;
         }
@@ -102,7 +126,7 @@ namespace graph {
         std::vector<EdgeId> edges;
         for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
              edge_id;
-             edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge)
+             edge_id = GetRoute(from, graph_.GetEdge(*edge_id).from)->prev_edge)
         {
             edges.push_back(*edge_id);
         }
@@ -114,28 +138,70 @@ namespace graph {
     template <typename Weight>
     const std::optional<typename Router<Weight>::RouteInternalData>& Router<Weight>::GetData(VertexId from,
                                                                                             VertexId to) const {
-        return routes_internal_data_.at(from).at(to);
+        if (from >= source_count_ || to >= vertex_count_) {
+            throw std::out_of_range("Route vertex is out of range");
+        }
+        return GetRoute(from, to);
+    }
+
+    template <typename Weight>
+    size_t Router<Weight>::GetSourceCount() const {
+        return source_count_;
     }
 
     template <typename Weight>
-    Router<Weight>::Router(const Graph& graph, VertexId vertex_count)
+    Router<Weight>::Router(const Graph& graph, size_t source_count, size_t vertex_count)
         : graph_(graph)
-        , routes_internal_data_(vertex_count, std::vector<std::optional<RouteInternalData>>(vertex_count)) {
+        , source_count_(source_count)
+        , vertex_count_(vertex_count)
+        , routes_internal_data_(source_count * vertex_count) {
     }
 
     template <typename Weight>
     void Router<Weight>::InitializeRoutesInternalData(const Graph& graph) {
         const size_t vertex_count = graph.GetVertexCount();
         for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
-            routes_internal_data_[vertex][vertex] = RouteInternalData{ZERO_WEIGHT, std::nullopt};
-            for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
-                const auto& edge = graph.GetEdge(edge_id);
-                if (edge.weight < ZERO_WEIGHT) {
+            GetRoute(vertex, vertex) = RouteInternalData{ZERO_WEIGHT, std::nullopt};
+            const size_t incident_end = graph.GetIncidentEnd(vertex);
+            for (size_t position = graph.GetIncidentBegin(vertex); position != incident_end; ++position) {
+                const Weight weight = graph.GetWeight(position);
+                if (weight < ZERO_WEIGHT) {
+                    throw std::domain_error("Edges' weights should be non-negative");
+                }
+                auto& route_internal_data = GetRoute(vertex, graph.GetTarget(position));
+                if (!route_internal_data || route_internal_data->weight > weight) {
+                    route_internal_data = RouteInternalData{weight, graph.GetEdgeId(position)};
+                }
+            }
+        }
+    }
+
+    template <typename Weight>
+    void Router<Weight>::BuildRoutesFromSource(const Graph& graph, VertexId source) {
+        using QueueItem = std::pair<Weight, VertexId>;
+        auto* routes = &GetRoute(source, 0);
+        routes[source] = RouteInternalData{ZERO_WEIGHT, std::nullopt};
+
+        std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+        queue.emplace(ZERO_WEIGHT, source);
+        while (!queue.empty()) {
+            const auto [weight, vertex] = queue.top();
+            queue.pop();
+            if (routes[vertex]->weight < weight) {
+                continue;
+            }
+            const size_t incident_end = graph.GetIncidentEnd(vertex);
+            for (size_t position = graph.GetIncidentBegin(vertex); position != incident_end; ++position) {
+                const Weight edge_weight = graph.GetWeight(position);
+                if (edge_weight < ZERO_WEIGHT) {
                     throw std::domain_error("Edges' weights should be non-negative");
                 }
-                auto& route_internal_data = routes_internal_data_[vertex][edge.to];
-                if (!route_internal_data || route_internal_data->weight > edge.weight) {
-                    route_internal_data = RouteInternalData{edge.weight, edge_id};
+                const VertexId vertex_to = graph.GetTarget(position);
+                const Weight candidate_weight = weight + edge_weight;
+                auto& route_to = routes[vertex_to];
+                if (!route_to || candidate_weight < route_to->weight) {
+                    route_to = RouteInternalData{candidate_weight, graph.GetEdgeId(position)};
+                    queue.emplace(candidate_weight, vertex_to);
                 }
             }
         }
@@ -144,7 +210,7 @@ namespace graph {
     template <typename Weight>
     void Router<Weight>::RelaxRoute(VertexId vertex_from, VertexId vertex_to, const RouteInternalData& route_from,
                     const RouteInternalData& route_to) {
-        auto& route_relaxing = routes_internal_data_[vertex_from][vertex_to];
+        auto& route_relaxing = GetRoute(vertex_from, vertex_to);
         const Weight candidate_weight = route_from.weight + route_to.weight;
         if (!route_relaxing || candidate_weight < route_relaxing->weight) {
             route_relaxing = {candidate_weight,
@@ -155,9 +221,9 @@ namespace graph {
     template <typename Weight>
     void Router<Weight>::RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through) {
         for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
-            if (const auto& route_from = routes_internal_data_[vertex_from][vertex_through]) {
+            if (const auto& route_from = GetRoute(vertex_from, vertex_through)) {
                 for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
-                    if (const auto& route_to = routes_internal_data_[vertex_through][vertex_to]) {
+                    if (const auto& route_to = GetRoute(vertex_through, vertex_to)) {
                         RelaxRoute(vertex_from, vertex_to, *route_from, *route_to);
                     }
                 }
@@ -165,12 +231,23 @@ namespace graph {
         }
     }
 
+    template <typename Weight>
+    std::optional<typename Router<Weight>::RouteInternalData>& Router<Weight>::GetRoute(VertexId from, VertexId to) {
+        return routes_internal_data_[from * vertex_count_ + to];
+    }
+
+    template <typename Weight>
+    const std::optional<typename Router<Weight>::RouteInternalData>& Router<Weight>::GetRoute(VertexId from,
+                                                                                             VertexId to) const {
+        return routes_internal_data_[from * vertex_count_ + to];
+    }
+
 
     //-------RouterCreatorHelper--------
 
     template <typename Weight>
-    RouterCreatorHelper<Weight>::RouterCreatorHelper(const Graph& graph)
-        : router_(graph, graph.GetVertexCount()) {
+    RouterCreatorHelper<Weight>::RouterCreatorHelper(const Graph& graph, size_t source_count)
+        : router_(graph, source_count, graph.GetVertexCount()) {
     }
 
     template <typename Weight>
@@ -179,7 +256,7 @@ namespace graph {
     }
     template <typename Weight>
     void RouterCreatorHelper<Weight>::AddData(VertexId from, VertexId to, std::optional<RouteInternalData>&& data) {
-        router_.routes_internal_data_[from][to] = data;
+        router_.GetRoute(from, to) = data;
     }
 
 }  // namespace graph
\ No newline at end of file
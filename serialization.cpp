@@ -1,70 +1,62 @@
 #include "serialization.h"
 
 #include <fstream>
+#include <sstream>
 
 namespace transport_catalogue::proto {
 
     namespace {
-        using ProtoMap = google::protobuf::Map<std::string, uint64_t>;
-
         void SaveStops(const TransportCatalogue& source, tcs::Catalogue& destination) {
-            auto tcs_stops = destination.mutable_stop();
             for (const domain::Stop& stop : source.GetStops()) {
-                tcs::Stop tcs_stop;
-                tcs_stop.set_name(stop.name);
+                tcs::Stop& tcs_stop = *destination.add_stop();
+                tcs_stop.set_name(std::string{stop.name});
 
-                tcs::Coordinates tcs_coordinates;
+                tcs::Coordinates& tcs_coordinates = *tcs_stop.mutable_coordinates();
                 tcs_coordinates.set_lat(stop.coordinates.lat);
                 tcs_coordinates.set_lng(stop.coordinates.lng);
-                *tcs_stop.mutable_coordinates() = std::move(tcs_coordinates);
-
-                tcs_stops->Add(std::move(tcs_stop));
             }
         }
 
         void SaveDistances(const TransportCatalogue& source, tcs::Catalogue& destination) {
-            auto tcs_distances = destination.mutable_distance();
-
-            for (const auto&[stops, distance] : source.GetDistanceBetweenStops()) {
-                const auto&[from_stop, to_stop] = stops;
-                tcs::DistanceBetweenStops tcs_distance;
-                tcs_distance.set_from_stop(from_stop->name);
-                tcs_distance.set_to_stop(to_stop->name);
-                tcs_distance.set_distance(distance);
-                tcs_distances->Add(std::move(tcs_distance));
+            for (domain::StopId from_stop = 0; from_stop < source.GetStops().size(); ++from_stop) {
+                for (const auto& [to_stop, distance, is_explicit] : source.GetRoadDistances(from_stop)) {
+                    if (!is_explicit) {
+                        continue;
+                    }
+                    tcs::DistanceBetweenStops& tcs_distance = *destination.add_distance();
+                    tcs_distance.set_from_stop(from_stop);
+                    tcs_distance.set_to_stop(to_stop);
+                    tcs_distance.set_distance(distance);
+                }
             }
         }
 
         void SaveBuses(const TransportCatalogue& source, tcs::Catalogue& destination) {
-            auto tcs_buses = destination.mutable_bus();
-            for (const auto& [bus_number, stops]: source.GetRoutes()) {
-                tcs::Bus tcs_bus;
-                domain::Bus* ptr_bus = source.FindRoute(bus_number);
-                tcs_bus.set_number(ptr_bus->number);
-                tcs_bus.set_is_roundtrip(ptr_bus->is_roundtrip);
-
-                for (const std::string_view stop : stops) {
-                    *tcs_bus.add_stop() = stop;
-                }
-
-                tcs_buses->Add(std::move(tcs_bus));
+            for (const domain::Bus& bus : source.GetBuses()) {
+                tcs::Bus& tcs_bus = *destination.add_bus();
+                tcs_bus.set_number(std::string{bus.number});
+                tcs_bus.set_is_roundtrip(bus.is_roundtrip);
+                tcs_bus.mutable_stop()->Add(bus.stops.begin(), bus.stops.end());
+
+                tcs::RouteStats& tcs_stats = *tcs_bus.mutable_stats();
+                tcs_stats.set_stops_on_route(bus.stops_on_route);
+                tcs_stats.set_unique_stops(bus.unique_stops);
+                tcs_stats.set_route_length(bus.route_length);
+                tcs_stats.set_curvature(bus.curvature);
             }
         }
 
-        tcs::Point SavePoint(const svg::Point& point) {
-            tcs::Point result;
-            result.set_x(point.x);
-            result.set_y(point.y);
-            return result;
+        void SavePoint(const svg::Point& point, tcs::Point& destination) {
+            destination.set_x(point.x);
+            destination.set_y(point.y);
         }
 
-        tcs::Color SaveColor(const svg::Color& color) {
-            tcs::Color result;
+        void SaveColor(const svg::Color& color, tcs::Color& destination) {
             if (std::holds_alternative<std::string>(color)) {
                 std::string str = std::get<std::string>(color);
-                result.set_name(str);
+                destination.set_name(str);
             } else {
-                auto& tcs_rgba = *result.mutable_rgba();
+                auto& tcs_rgba = *destination.mutable_rgba();
 
                 if (std::holds_alternative<svg::Rgb>(color)) {
                     svg::Rgb svg_rgb = std::get<svg::Rgb>(color);
@@ -82,121 +74,167 @@ namespace transport_catalogue::proto {
                     tcs_rgba.set_is_rgba(true);
                 }
             }
-            return result;
         }
 
-        tcs::RouteRenderer SaveRouteRenderer(const renderer::RouteRenderer& renderer) {
-            tcs::RouteRenderer result;
-            result.set_line_width(renderer.GetLineWidth());
-            *result.mutable_stroke_color() = SaveColor(renderer.GetStrokeColor());
+        void SaveRouteRenderer(const renderer::RouteRenderer& renderer, tcs::RouteRenderer& destination) {
+            destination.set_line_width(renderer.GetLineWidth());
+            destination.set_is_roundtrip(renderer.IsRoundtrip());
+            SaveColor(renderer.GetStrokeColor(), *destination.mutable_stroke_color());
 
             for (const auto& stop_coordinate : renderer.GetStopCoordinates()) {
-                *result.add_stops_coordinates() = std::move(SavePoint(stop_coordinate));
+                SavePoint(stop_coordinate, *destination.add_stops_coordinates());
             }
-            return result;
         }
 
-        tcs::TextRenderer SaveTextRenderer(const renderer::TextRenderer& renderer) {
-            tcs::TextRenderer result;
-
-            *result.mutable_position() = std::move(SavePoint(renderer.GetPosition()));
-            *result.mutable_label_offset() = std::move(SavePoint(renderer.GetLabelOffset()));
-            result.set_label_font_size(renderer.GetLabelFontSize());
+        void SaveTextRenderer(const renderer::TextRenderer& renderer, tcs::TextRenderer& destination) {
+            SavePoint(renderer.GetPosition(), *destination.mutable_position());
+            SavePoint(renderer.GetLabelOffset(), *destination.mutable_label_offset());
+            destination.set_label_font_size(renderer.GetLabelFontSize());
 
             const auto& font_weight = renderer.GetFontWeight();
             if (font_weight) {
-                result.set_has_font_weight(true);
-                result.set_font_weight(font_weight.value());
-                //std::cout << result.font_weight() << std::endl;
+                destination.set_has_font_weight(true);
+                destination.set_font_weight(font_weight.value());
             } else {
-                result.set_has_font_weight(false);
+                destination.set_has_font_weight(false);
             }
 
-            result.set_text(renderer.GetText());
-            *result.mutable_underlayer_color() = std::move(SaveColor(renderer.GetUnderlayerColor()));
-            result.set_underlayer_width(renderer.GetUnderlayerWidth());
-            *result.mutable_text_color() = std::move(SaveColor(renderer.GetTextColor()));
-
-            return result;
+            destination.set_text(renderer.GetText());
+            SaveColor(renderer.GetUnderlayerColor(), *destination.mutable_underlayer_color());
+            destination.set_underlayer_width(renderer.GetUnderlayerWidth());
+            SaveColor(renderer.GetTextColor(), *destination.mutable_text_color());
         }
 
-        tcs::StopRenderer SaveStopRenderer(const renderer::StopRenderer& renderer) {
-            tcs::StopRenderer result;
-            *result.mutable_centre() = std::move(SavePoint(renderer.GetCentre()));
-            result.set_stop_radius(renderer.GetStopRadius());
-            return result;
+        void SaveStopRenderer(const renderer::StopRenderer& renderer, tcs::StopRenderer& destination) {
+            SavePoint(renderer.GetCentre(), *destination.mutable_centre());
+            destination.set_stop_radius(renderer.GetStopRadius());
         }
 
-        tcs::Item SaveItem(const router::Item& item) {
-            tcs::Item result;
-
-            switch (item.type) {
-                case router::ItemType::WAIT:
-                    result.set_type(tcs::Item::WAIT);
-                    break;
+        tcs::Item::WeightType SaveItemType(router::ItemType type) {
+            switch (type) {
                 case router::ItemType::BUS:
-                    result.set_type(tcs::Item::BUS);
-                    break;
+                    return tcs::Item::BUS;
+                case router::ItemType::ALIGHT:
+                    return tcs::Item::ALIGHT;
                 default:
-                    break;
+                    return tcs::Item::WAIT;
             }
-
-            result.set_span_count(item.span_count);
-            result.set_name(std::string{item.name});
-            return result;
         }
 
-        tcs::Edge SaveEdge(const graph::Edge<router::Minutes>& edge) {
-            tcs::Edge result;
-            result.set_from(edge.from);
-            result.set_to(edge.to);
-            result.set_weight(edge.weight);
-            return result;
+        void SaveEdge(const graph::Edge<router::Minutes>& edge, tcs::Edge& destination) {
+            destination.set_from(edge.from);
+            destination.set_to(edge.to);
+            destination.set_weight(edge.weight);
         }
 
         void SaveGraph(const router::TransportRouter::Graph& source, tcs::Graph& destination) {
             destination.set_vertex_count(source.GetVertexCount());
             const graph::EdgeId edges_count = source.GetEdgeCount();
 
+            destination.mutable_edge()->Reserve(static_cast<int>(edges_count));
             for (graph::EdgeId id = 0; id < edges_count; ++id) {
-                const auto& edge = source.GetEdge(id);
-                *destination.add_edge() = std::move(SaveEdge(edge));
+                SaveEdge(source.GetEdge(id), *destination.add_edge());
             }
         }
 
-        void SaveIndexes(const router::TransportRouter::IndexMap& source, ProtoMap& destination) {
-            using MapPair = google::protobuf::MapPair<std::string, uint64_t>;
+        void SavePerfectHash(const domain::PerfectHash& perfect_hash, tcs::PerfectHash& destination) {
+            const auto& displacements = perfect_hash.GetDisplacements();
+            const auto& values = perfect_hash.GetValues();
+            destination.mutable_displacement()->Add(displacements.begin(), displacements.end());
+            destination.mutable_value()->Add(values.begin(), values.end());
+        }
 
-            for (const auto& [name, index] : source) {
-                destination.insert(MapPair {std::string{name}, index});
+        // Хэши названий строятся по окончательному набору остановок и автобусов, значения - их номера
+        void SaveNameHashes(const TransportCatalogue& source, tcs::Catalogue& destination) {
+            std::vector<std::string_view> names;
+            std::vector<uint32_t> ids;
+            for (const auto& stop : source.GetStops()) {
+                names.push_back(stop.name);
+                ids.push_back(stop.id);
             }
+            SavePerfectHash(domain::PerfectHash(names, ids), *destination.mutable_stop_hash());
+
+            names.clear();
+            ids.clear();
+            for (const auto& bus : source.GetBuses()) {
+                names.push_back(bus.number);
+                ids.push_back(bus.id);
+            }
+            SavePerfectHash(domain::PerfectHash(names, ids), *destination.mutable_bus_hash());
+        }
+
+        void SaveWaitVertexes(const router::TransportRouter& source, tcs::TransportRouter& destination) {
+            const auto& wait_vertexes = source.GetWaitVertexes();
+            destination.mutable_wait_vertex()->Add(wait_vertexes.begin(), wait_vertexes.end());
+            SavePerfectHash(source.GetStopHash(), *destination.mutable_stop_hash());
         }
 
         void SaveItems(const router::TransportRouter& source, tcs::TransportRouter& destination) {
-            for (const auto& item : source.GetItems()) {
-                *destination.add_item() = std::move(SaveItem(item));
+            const auto& items = source.GetItems();
+            destination.mutable_item_type()->Reserve(static_cast<int>(items.size()));
+            destination.mutable_item_span_count()->Reserve(static_cast<int>(items.size()));
+            destination.mutable_item_name_id()->Reserve(static_cast<int>(items.size()));
+            for (const auto& item : items) {
+                destination.add_item_type(SaveItemType(item.type));
+                destination.add_item_span_count(item.span_count);
+                destination.add_item_name_id(item.name_id);
+            }
+            for (const auto name : source.GetStopNames()) {
+                destination.add_stop_name(std::string{name});
+            }
+            for (const auto name : source.GetBusNames()) {
+                destination.add_bus_name(std::string{name});
             }
         }
 
-        void LoadStops(const tcs::Catalogue& source, TransportCatalogue& destination) {
-            for (const tcs::Stop& stop : source.stop()) {
-                const tcs::Coordinates& coordinates = stop.coordinates();
-                destination.AddStop(stop.name(), {coordinates.lat(), coordinates.lng()});
+        void SaveRouteItem(const request_handler::RouteItem& item, tcs::RouteItem& destination) {
+            destination.set_type(item.type == router::ItemType::WAIT ? tcs::Item::WAIT : tcs::Item::BUS);
+            destination.set_name(item.name);
+            if (item.type != router::ItemType::WAIT) {
+                destination.set_span_count(item.span_count);
             }
+            destination.set_time(item.time);
         }
 
-        void LoadDistances(const tcs::Catalogue& source, TransportCatalogue& destination) {
-            for (const tcs::DistanceBetweenStops& dbs : source.distance()) {
-                destination.AddDistanceBetweenStops(dbs.from_stop(), dbs.to_stop(), dbs.distance());
+        void SaveHotRoute(const request_handler::HotRoutes::Entry& entry, tcs::HotRoute& destination) {
+            destination.set_from(entry.key.first);
+            destination.set_to(entry.key.second);
+            if (entry.route) {
+                destination.set_has_route(true);
+                destination.set_total_time(entry.route->total_time);
+                for (const auto& item : entry.route->items) {
+                    SaveRouteItem(item, *destination.add_item());
+                }
+            } else {
+                destination.set_has_route(false);
             }
         }
 
-        void LoadBuses(const tcs::Catalogue& source, TransportCatalogue& destination) {
+        // Остановки в расстояниях и маршрутах базы заданы номерами, поэтому названия разрешать не нужно
+        TransportCatalogue::BaseInput<domain::StopId> LoadBaseInput(const tcs::Catalogue& source) {
+            TransportCatalogue::BaseInput<domain::StopId> result;
+            result.stops.reserve(source.stop_size());
+            for (const tcs::Stop& stop : source.stop()) {
+                const tcs::Coordinates& coordinates = stop.coordinates();
+                result.stops.push_back({stop.name(), {coordinates.lat(), coordinates.lng()}});
+            }
+            result.distances.reserve(source.distance_size());
+            for (const tcs::DistanceBetweenStops& dbs : source.distance()) {
+                result.distances.push_back({dbs.from_stop(), dbs.to_stop(), dbs.distance()});
+            }
+            result.buses.reserve(source.bus_size());
             for (const tcs::Bus& bus : source.bus()) {
-                std::vector<std::string> stops(bus.stop_size());
-                std::move(bus.stop().begin(), bus.stop().end(), stops.begin());
-                destination.AddRoute(bus.number(), stops, bus.is_roundtrip());
+                auto& bus_input = result.buses.emplace_back();
+                bus_input.number = bus.number();
+                bus_input.stops.assign(bus.stop().begin(), bus.stop().end());
+                bus_input.is_roundtrip = bus.is_roundtrip();
+                if (bus.has_stats()) {
+                    const tcs::RouteStats& stats = bus.stats();
+                    bus_input.stats = {stats.stops_on_route(), stats.unique_stops(), stats.route_length(),
+                                       stats.curvature()};
+                }
             }
+            return result;
         }
 
         svg::Point LoadPoint(const tcs::Point& point) {
@@ -231,13 +269,14 @@ namespace transport_catalogue::proto {
 
         renderer::RouteRenderer LoadRouteRenderer(const tcs::RouteRenderer& renderer) {
             std::vector<svg::Point> stops_coordinates;
+            stops_coordinates.reserve(renderer.stops_coordinates_size());
             for (const auto& stop_coordinate : renderer.stops_coordinates()) {
                 stops_coordinates.push_back(LoadPoint(stop_coordinate));
             }
 
             svg::Color stroke_color = LoadColor(renderer.stroke_color());
 
-            return {std::move(stops_coordinates), std::move(stroke_color), renderer.line_width()};
+            return {std::move(stops_coordinates), std::move(stroke_color), renderer.line_width(), renderer.is_roundtrip()};
         }
 
         renderer::TextRenderer LoadTextRenderer(const tcs::TextRenderer& renderer) {
@@ -296,83 +335,118 @@ namespace transport_catalogue::proto {
             return stops_names;
         }
 
-        router::Item LoadItem(const tcs::Item& item) {
+        router::ItemType LoadItemType(int item_type) {
             router::ItemType type;
-            switch (item.type()) {
+            switch (item_type) {
                 case tcs::Item::WAIT:
                     type = router::ItemType::WAIT;
                     break;
                 case tcs::Item::BUS:
                     type = router::ItemType::BUS;
                     break;
+                case tcs::Item::ALIGHT:
+                    type = router::ItemType::ALIGHT;
+                    break;
                 default:
                     assert(false);
             }
-            return {type, item.span_count(), item.name()};
+            return type;
+        }
+
+        request_handler::RouteItem LoadRouteItem(const tcs::RouteItem& item) {
+            if (item.type() == tcs::Item::WAIT) {
+                return {router::ItemType::WAIT, item.name(), 0, item.time()};
+            }
+            return {router::ItemType::BUS, item.name(), item.span_count(), item.time()};
+        }
+
+        request_handler::HotRoutes::Entry LoadHotRoute(const tcs::HotRoute& hot_route) {
+            request_handler::HotRoutes::Key key {hot_route.from(), hot_route.to()};
+            if (!hot_route.has_route()) {
+                return {key, std::nullopt};
+            }
+            request_handler::RouteItems route;
+            route.items.reserve(hot_route.item_size());
+            for (const auto& item : hot_route.item()) {
+                route.items.push_back(LoadRouteItem(item));
+            }
+            route.total_time = hot_route.total_time();
+            return {key, std::move(route)};
         }
 
-        void LoadGraph(const tcs::TransportRouter& source, router::TransportRouter& destination) {
-            for (const auto& edge : source.graph().edge()) {
-                destination.AddEdge({edge.from(), edge.to(), edge.weight()});
+        router::TransportRouter::Graph LoadGraph(const tcs::Graph& source) {
+            std::vector<graph::Edge<router::Minutes>> edges;
+            edges.reserve(source.edge_size());
+            for (const auto& edge : source.edge()) {
+                edges.push_back({edge.from(), edge.to(), edge.weight()});
             }
+            return router::TransportRouter::Graph(source.vertex_count(), std::move(edges));
+        }
+
+        domain::PerfectHash LoadPerfectHash(const tcs::PerfectHash& perfect_hash) {
+            return domain::PerfectHash{
+                    std::vector<uint32_t>(perfect_hash.displacement().begin(), perfect_hash.displacement().end()),
+                    std::vector<uint32_t>(perfect_hash.value().begin(), perfect_hash.value().end())};
         }
 
-        void LoadIndexes(const tcs::TransportRouter& source, router::TransportRouter& destination) {
-            for(const auto& [name, index] : source.wait_index()) {
-                destination.AddWaitIndex(name, index);
+        void LoadWaitVertexes(const tcs::TransportRouter& source, router::TransportRouter& destination) {
+            for (const uint64_t vertex : source.wait_vertex()) {
+                destination.AddWaitVertex(vertex);
             }
+            destination.SetStopHash(LoadPerfectHash(source.stop_hash()));
         }
 
         void LoadItems(const tcs::TransportRouter& source, router::TransportRouter& destination) {
-            for(const auto& item : source.item()) {
-                router::Item added = LoadItem(item);
-                destination.AddItem(added);
+            for (int i = 0; i < source.item_type_size(); ++i) {
+                destination.AddItem({LoadItemType(source.item_type(i)), static_cast<int>(source.item_span_count(i)),
+                                     source.item_name_id(i)});
+            }
+            for (const auto& name : source.stop_name()) {
+                destination.AddStopName(name);
+            }
+            for (const auto& name : source.bus_name()) {
+                destination.AddBusName(name);
             }
         }
     }
 
-    tcs::Catalogue SaveCatalogue(const TransportCatalogue& catalogue) {
-        tcs::Catalogue result;
-        SaveBuses(catalogue, result);
-        SaveStops(catalogue, result);
-        SaveDistances(catalogue, result);
-        return result;
+    void SaveCatalogue(const TransportCatalogue& catalogue, tcs::Catalogue& destination) {
+        SaveBuses(catalogue, destination);
+        SaveStops(catalogue, destination);
+        SaveDistances(catalogue, destination);
+        SaveNameHashes(catalogue, destination);
     }
 
-    tcs::MapRenderer SaveMapRenderer(const renderer::MapRenderer& map_renderer) {
-        tcs::MapRenderer result;
-
+    void SaveMapRenderer(const renderer::MapRenderer& map_renderer, tcs::MapRenderer& destination) {
         for (const auto& route : map_renderer.GetRoutes()) {
-            *result.add_routes() = std::move(SaveRouteRenderer(route));
+            SaveRouteRenderer(route, *destination.add_routes());
         }
 
         for (const auto& text : map_renderer.GetRoutesNames()) {
-            *result.add_routes_names() = std::move(SaveTextRenderer(text));
+            SaveTextRenderer(text, *destination.add_routes_names());
         }
 
         for (const auto& stop : map_renderer.GetStops()) {
-            *result.add_stops() = std::move(SaveStopRenderer(stop));
+            SaveStopRenderer(stop, *destination.add_stops());
         }
 
         for (const auto& text : map_renderer.GetStopsNames()) {
-            *result.add_stops_names() = std::move(SaveTextRenderer(text));
+            SaveTextRenderer(text, *destination.add_stops_names());
         }
-
-        return result;
     }
 
-    tcs::TransportRouter SaveTransportRouter(const router::TransportRouter& router) {
-        tcs::TransportRouter result;
-        SaveGraph(router.GetGraph(), *result.mutable_graph());
-        SaveIndexes(router.GetWaitIndexes(), *result.mutable_wait_index());
-        SaveItems(router, result);
-        return result;
+    void SaveTransportRouter(const router::TransportRouter& router, tcs::TransportRouter& destination) {
+        SaveGraph(router.GetGraph(), *destination.mutable_graph());
+        SaveWaitVertexes(router, destination);
+        SaveItems(router, destination);
     }
 
-    tcs::Router SaveRouter(const graph::Router<router::Minutes>& router, graph::VertexId vertex_count) {
-        tcs::Router result;
-        for (graph::VertexId from = 0; from < vertex_count; ++from) {
-            auto& routes_internal_data = *result.add_routes_internal_data();
+    void SaveRouter(const graph::Router<router::Minutes>& router, graph::VertexId vertex_count,
+                    tcs::Router& destination) {
+        destination.mutable_routes_internal_data()->Reserve(static_cast<int>(router.GetSourceCount()));
+        for (graph::VertexId from = 0; from < router.GetSourceCount(); ++from) {
+            auto& routes_internal_data = *destination.add_routes_internal_data();
+            routes_internal_data.mutable_data()->Reserve(static_cast<int>(vertex_count));
             for (graph::VertexId to = 0; to < vertex_count; ++to) {
                 const auto& route_info = router.GetData(from, to);
                 auto& data = *routes_internal_data.add_data();
@@ -390,14 +464,18 @@ namespace transport_catalogue::proto {
                 }
             }
         }
-        return result;
+    }
+
+    void SaveHotRoutes(const request_handler::HotRoutes& hot_routes, tcs::HotRoutes& destination) {
+        for (const auto& entry : hot_routes.GetRoutes()) {
+            SaveHotRoute(entry, *destination.add_route());
+        }
     }
 
     TransportCatalogue LoadCatalogue(const tcs::Catalogue& catalogue) {
         TransportCatalogue result;
-        LoadStops(catalogue, result);
-        LoadDistances(catalogue, result);
-        LoadBuses(catalogue, result);
+        result.SetNameHashes(LoadPerfectHash(catalogue.stop_hash()), LoadPerfectHash(catalogue.bus_hash()));
+        result.AddBase(LoadBaseInput(catalogue));
         return result;
     }
 
@@ -411,17 +489,15 @@ namespace transport_catalogue::proto {
     }
 
     router::TransportRouter LoadTransportRouter(const tcs::TransportRouter& router) {
-        size_t vertex_count = router.graph().vertex_count();
-        router::TransportRouter result(vertex_count);
-        LoadGraph(router, result);
-        LoadIndexes(router, result);
+        router::TransportRouter result(LoadGraph(router.graph()));
+        LoadWaitVertexes(router, result);
         LoadItems(router, result);
         return result;
     }
 
     graph::Router<router::Minutes> LoadRouter(const tcs::Router& router, const router::TransportRouter::Graph& graph) {
         using Helper = graph::RouterCreatorHelper<router::Minutes>;
-        Helper helper(graph);
+        Helper helper(graph, router.routes_internal_data_size());
 
         for (graph::VertexId from = 0; from < router.routes_internal_data_size(); ++from) {
             for (graph::VertexId to = 0; to < router.routes_internal_data(from).data_size(); ++to) {
@@ -442,4 +518,61 @@ namespace transport_catalogue::proto {
         }
         return helper.BuildRouter();
     }
+
+    request_handler::HotRoutes LoadHotRoutes(const tcs::HotRoutes& hot_routes) {
+        std::vector<request_handler::HotRoutes::Entry> routes;
+        routes.reserve(hot_routes.route_size());
+        for (const auto& hot_route : hot_routes.route()) {
+            routes.push_back(LoadHotRoute(hot_route));
+        }
+        return request_handler::HotRoutes{std::move(routes)};
+    }
+
+    void SaveStopSpatialIndex(const spatial::StopSpatialIndex& stop_index, tcs::StopSpatialIndex& destination) {
+        const auto& order = stop_index.GetOrder();
+        destination.mutable_stop()->Add(order.begin(), order.end());
+    }
+
+    spatial::StopSpatialIndex LoadStopSpatialIndex(const tcs::StopSpatialIndex& stop_index,
+                                                   const TransportCatalogue& catalogue) {
+        return spatial::StopSpatialIndex{catalogue, {stop_index.stop().begin(), stop_index.stop().end()}};
+    }
+
+    void SaveStopNameIndex(const search::StopNameIndex& name_index, tcs::StopNameIndex& destination) {
+        const auto& order = name_index.GetOrder();
+        destination.mutable_stop()->Add(order.begin(), order.end());
+    }
+
+    search::StopNameIndex LoadStopNameIndex(const tcs::StopNameIndex& name_index, const TransportCatalogue& catalogue) {
+        return search::StopNameIndex{catalogue, {name_index.stop().begin(), name_index.stop().end()}};
+    }
+
+    void SaveBuildSettings(const json::Dict& settings, tcs::BuildSettings& destination) {
+        const auto print_section = [&settings](const std::string& key) {
+            const auto found_section = settings.find(key);
+            if (found_section == settings.end()) {
+                return std::string{};
+            }
+            std::ostringstream out;
+            json::Print(json::Document{found_section->second}, out);
+            return out.str();
+        };
+        destination.set_render_settings(print_section("render_settings"));
+        destination.set_routing_settings(print_section("routing_settings"));
+        destination.set_hot_routes_settings(print_section("hot_routes_settings"));
+    }
+
+    json::Dict LoadBuildSettings(const tcs::BuildSettings& build_settings) {
+        json::Dict result;
+        const auto load_section = [&result](const std::string& key, const std::string& text) {
+            if (!text.empty()) {
+                std::istringstream in(text);
+                result.emplace(key, json::Load(in).GetRoot());
+            }
+        };
+        load_section("render_settings", build_settings.render_settings());
+        load_section("routing_settings", build_settings.routing_settings());
+        load_section("hot_routes_settings", build_settings.hot_routes_settings());
+        return result;
+    }
 }
\ No newline at end of file
@@ -1,23 +1,45 @@
 #pragma once
 
+#include <cstdint>
+
 #include <map_renderer.pb.h>
 #include <transport_catalogue.pb.h>
 #include <transport_router.pb.h>
 
 #include "map_renderer.h"
+#include "request_handler.h"
+#include "spatial_index.h"
+#include "stop_search.h"
 #include "transport_catalogue.h"
 #include "transport_router.h"
 
 namespace transport_catalogue::proto {
     namespace tcs = transport_catalogue_serialize;
 
-    tcs::Catalogue SaveCatalogue(const TransportCatalogue& catalogue);
-    tcs::MapRenderer SaveMapRenderer(const renderer::MapRenderer& map_renderer);
-    tcs::TransportRouter SaveTransportRouter(const router::TransportRouter& router);
-    tcs::Router SaveRouter(const graph::Router<router::Minutes>& router, graph::VertexId vertex_count);
+    // Версия формата базы. Увеличивается при каждом изменении сохраняемых сообщений, несовместимом с прежними базами
+    const uint32_t BASE_FORMAT_VERSION = 1;
+
+    // Части базы записываются прямо в сообщение destination: вложенные сообщения создаются на той же арене,
+    // что и оно, и не копируются между кучей и ареной
+    void SaveCatalogue(const TransportCatalogue& catalogue, tcs::Catalogue& destination);
+    void SaveMapRenderer(const renderer::MapRenderer& map_renderer, tcs::MapRenderer& destination);
+    void SaveTransportRouter(const router::TransportRouter& router, tcs::TransportRouter& destination);
+    void SaveRouter(const graph::Router<router::Minutes>& router, graph::VertexId vertex_count,
+                    tcs::Router& destination);
+    void SaveHotRoutes(const request_handler::HotRoutes& hot_routes, tcs::HotRoutes& destination);
+    void SaveStopSpatialIndex(const spatial::StopSpatialIndex& stop_index, tcs::StopSpatialIndex& destination);
+    void SaveStopNameIndex(const search::StopNameIndex& name_index, tcs::StopNameIndex& destination);
+    // Сохраняет разделы настроек построения базы из запроса make_base
+    void SaveBuildSettings(const json::Dict& settings, tcs::BuildSettings& destination);
 
     TransportCatalogue LoadCatalogue(const tcs::Catalogue& catalogue);
     renderer::MapRenderer LoadMapRenderer(const tcs::MapRenderer& map_renderer);
     router::TransportRouter LoadTransportRouter(const tcs::TransportRouter& router);
     graph::Router<router::Minutes> LoadRouter(const tcs::Router& router, const router::TransportRouter::Graph& graph);
+    request_handler::HotRoutes LoadHotRoutes(const tcs::HotRoutes& hot_routes);
+    spatial::StopSpatialIndex LoadStopSpatialIndex(const tcs::StopSpatialIndex& stop_index,
+                                                   const TransportCatalogue& catalogue);
+    search::StopNameIndex LoadStopNameIndex(const tcs::StopNameIndex& name_index, const TransportCatalogue& catalogue);
+    // Разделы настроек, сохранённые в базе, в виде словаря запроса make_base
+    json::Dict LoadBuildSettings(const tcs::BuildSettings& build_settings);
 }
\ No newline at end of file
@@ -0,0 +1,429 @@
+#define _USE_MATH_DEFINES
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <tuple>
+
+#include "spatial_index.h"
+
+namespace transport_catalogue::spatial {
+    namespace {
+        // Запас в метрах на погрешность geo::ComputeDistance для близких точек при переводе радиуса поиска в хорду:
+        // окончательно отбирается по расстоянию
+        const double RADIUS_TOLERANCE = 1;
+
+        // Запас на погрешность вычисления точек сферы: окончательно отбирается по координатам
+        const double BOUNDS_TOLERANCE = 1e-12;
+
+        // Есть ли угол, отличающийся от angle на целое число оборотов, в отрезке [from, to]
+        bool ContainsAngle(double from, double to, double angle) {
+            const double turn = 2 * M_PI;
+            return angle + std::ceil((from - angle) / turn) * turn <= to;
+        }
+
+        // Область значений cos (is_sine = false) или sin на отрезке углов [from, to]
+        std::pair<double, double> ComputeTrigonometricRange(double from, double to, bool is_sine) {
+            const auto function = [is_sine](double angle) {
+                return is_sine ? std::sin(angle) : std::cos(angle);
+            };
+            const double maximum_at = is_sine ? M_PI / 2 : 0;
+            double lower = std::min(function(from), function(to));
+            double upper = std::max(function(from), function(to));
+            if (ContainsAngle(from, to, maximum_at)) {
+                upper = 1;
+            }
+            if (ContainsAngle(from, to, maximum_at + M_PI)) {
+                lower = -1;
+            }
+            return {lower, upper};
+        }
+
+        std::pair<double, double> MultiplyRanges(std::pair<double, double> lhs, std::pair<double, double> rhs) {
+            const double products[] = {lhs.first * rhs.first, lhs.first * rhs.second,
+                                       lhs.second * rhs.first, lhs.second * rhs.second};
+            return {*std::min_element(std::begin(products), std::end(products)),
+                    *std::max_element(std::begin(products), std::end(products))};
+        }
+
+        // Пересекает ли отрезок прямоугольник (отсечение Лианга-Барски)
+        bool IsSegmentCrossing(geo::Coordinates from, geo::Coordinates to, const GeoBox& box) {
+            if (box.Contains(from) || box.Contains(to)) {
+                return true;
+            }
+            const double delta[] = {to.lat - from.lat, to.lng - from.lng};
+            const double start[] = {from.lat, from.lng};
+            const double lower[] = {box.min.lat, box.min.lng};
+            const double upper[] = {box.max.lat, box.max.lng};
+            double enter = 0;
+            double leave = 1;
+            for (size_t axis = 0; axis < 2; ++axis) {
+                if (delta[axis] == 0) {
+                    if (start[axis] < lower[axis] || start[axis] > upper[axis]) {
+                        return false;
+                    }
+                    continue;
+                }
+                double to_lower = (lower[axis] - start[axis]) / delta[axis];
+                double to_upper = (upper[axis] - start[axis]) / delta[axis];
+                if (to_lower > to_upper) {
+                    std::swap(to_lower, to_upper);
+                }
+                enter = std::max(enter, to_lower);
+                leave = std::min(leave, to_upper);
+                if (enter > leave) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    }
+
+    //------------- GeoBox -------------
+
+    bool GeoBox::IsEmpty() const {
+        return min.lat > max.lat || min.lng > max.lng;
+    }
+
+    bool GeoBox::Contains(geo::Coordinates point) const {
+        return min.lat <= point.lat && point.lat <= max.lat && min.lng <= point.lng && point.lng <= max.lng;
+    }
+
+    bool GeoBox::Intersects(const GeoBox& other) const {
+        return min.lat <= other.max.lat && other.min.lat <= max.lat
+               && min.lng <= other.max.lng && other.min.lng <= max.lng;
+    }
+
+    void GeoBox::Extend(geo::Coordinates point) {
+        min = {std::min(min.lat, point.lat), std::min(min.lng, point.lng)};
+        max = {std::max(max.lat, point.lat), std::max(max.lng, point.lng)};
+    }
+
+    void GeoBox::Extend(const GeoBox& other) {
+        Extend(other.min);
+        Extend(other.max);
+    }
+
+    //-------- StopSpatialIndex --------
+
+    StopSpatialIndex::StopSpatialIndex(const TransportCatalogue& catalogue) {
+        const auto& stops = catalogue.GetStops();
+        std::vector<Point> points_by_stop;
+        points_by_stop.reserve(stops.size());
+        order_.reserve(stops.size());
+        for (const domain::Stop& stop : stops) {
+            points_by_stop.push_back(ToPoint(stop.coordinates));
+            order_.push_back(stop.id);
+        }
+        Build(0, order_.size(), 0, points_by_stop);
+        FillPoints(catalogue);
+    }
+
+    StopSpatialIndex::StopSpatialIndex(const TransportCatalogue& catalogue, std::vector<domain::StopId> order)
+        : order_(std::move(order)) {
+        std::vector<bool> is_seen(catalogue.GetStops().size());
+        const bool is_valid = order_.size() == is_seen.size()
+                              && std::all_of(order_.begin(), order_.end(), [&is_seen](domain::StopId stop) {
+            if (stop >= is_seen.size() || is_seen[stop]) {
+                return false;
+            }
+            is_seen[stop] = true;
+            return true;
+        });
+        if (!is_valid) {
+            *this = StopSpatialIndex(catalogue);
+            return;
+        }
+        FillPoints(catalogue);
+    }
+
+    std::vector<StopSpatialIndex::Neighbour> StopSpatialIndex::FindNearest(geo::Coordinates point, size_t count) const {
+        std::vector<Candidate> heap;
+        if (count == 0) {
+            return {};
+        }
+        heap.reserve(std::min(count, order_.size()) + 1);
+        SearchNearest(0, order_.size(), 0, ToPoint(point), count, heap);
+        return RankByDistance(point, heap);
+    }
+
+    std::vector<StopSpatialIndex::Neighbour> StopSpatialIndex::FindWithinRadius(geo::Coordinates point, double radius,
+                                                                                size_t max_count) const {
+        if (radius < 0) {
+            return {};
+        }
+        const double chord = 2 * std::sin(std::min((radius + RADIUS_TOLERANCE) / geo::EARTH_RADIUS, M_PI) / 2);
+        std::vector<Candidate> candidates;
+        SearchWithinChord(0, order_.size(), 0, ToPoint(point), chord * chord, candidates);
+        std::vector<Neighbour> result = RankByDistance(point, candidates);
+        const auto found_outside = std::find_if(result.begin(), result.end(), [radius](const Neighbour& neighbour) {
+            return neighbour.distance > radius;
+        });
+        result.erase(found_outside, result.end());
+        if (result.size() > max_count) {
+            result.resize(max_count);
+        }
+        return result;
+    }
+
+    std::vector<domain::StopId> StopSpatialIndex::FindInBox(const GeoBox& box) const {
+        std::vector<domain::StopId> result;
+        if (box.IsEmpty()) {
+            return result;
+        }
+        SearchInBounds(0, order_.size(), 0, ToPointBounds(box), box, result);
+        return result;
+    }
+
+    const std::vector<domain::StopId>& StopSpatialIndex::GetOrder() const {
+        return order_;
+    }
+
+    StopSpatialIndex::Point StopSpatialIndex::ToPoint(geo::Coordinates coordinates) {
+        const double dr = M_PI / 180.0;
+        const double lat = coordinates.lat * dr;
+        const double lng = coordinates.lng * dr;
+        return {{std::cos(lat) * std::cos(lng), std::cos(lat) * std::sin(lng), std::sin(lat)}};
+    }
+
+    std::pair<StopSpatialIndex::Point, StopSpatialIndex::Point> StopSpatialIndex::ToPointBounds(const GeoBox& box) {
+        const double dr = M_PI / 180.0;
+        const double min_lat = box.min.lat * dr;
+        const double max_lat = box.max.lat * dr;
+        const double min_lng = box.min.lng * dr;
+        const double max_lng = box.max.lng * dr;
+        const auto lat_cos = ComputeTrigonometricRange(min_lat, max_lat, false);
+        const auto x = MultiplyRanges(lat_cos, ComputeTrigonometricRange(min_lng, max_lng, false));
+        const auto y = MultiplyRanges(lat_cos, ComputeTrigonometricRange(min_lng, max_lng, true));
+        return {{{x.first - BOUNDS_TOLERANCE, y.first - BOUNDS_TOLERANCE, std::sin(min_lat) - BOUNDS_TOLERANCE}},
+                {{x.second + BOUNDS_TOLERANCE, y.second + BOUNDS_TOLERANCE, std::sin(max_lat) + BOUNDS_TOLERANCE}}};
+    }
+
+    double StopSpatialIndex::ComputeChordSquare(const Point& lhs, const Point& rhs) {
+        double result = 0;
+        for (size_t axis = 0; axis < 3; ++axis) {
+            const double diff = lhs.coordinates[axis] - rhs.coordinates[axis];
+            result += diff * diff;
+        }
+        return result;
+    }
+
+    void StopSpatialIndex::Build(size_t begin, size_t end, size_t depth, std::vector<Point>& points_by_stop) {
+        if (end - begin <= 1) {
+            return;
+        }
+        const size_t middle = begin + (end - begin) / 2;
+        const size_t axis = depth % 3;
+        std::nth_element(order_.begin() + begin, order_.begin() + middle, order_.begin() + end,
+                         [&points_by_stop, axis](domain::StopId lhs, domain::StopId rhs) {
+            return points_by_stop[lhs].coordinates[axis] < points_by_stop[rhs].coordinates[axis];
+        });
+        Build(begin, middle, depth + 1, points_by_stop);
+        Build(middle + 1, end, depth + 1, points_by_stop);
+    }
+
+    void StopSpatialIndex::FillPoints(const TransportCatalogue& catalogue) {
+        points_.clear();
+        coordinates_.clear();
+        points_.reserve(order_.size());
+        coordinates_.reserve(order_.size());
+        for (const domain::StopId stop : order_) {
+            coordinates_.push_back(catalogue.GetStop(stop).coordinates);
+            points_.push_back(ToPoint(coordinates_.back()));
+        }
+    }
+
+    // heap - куча с наибольшей хордой наверху, в ней не больше count кандидатов
+    void StopSpatialIndex::SearchNearest(size_t begin, size_t end, size_t depth, const Point& point, size_t count,
+                                         std::vector<Candidate>& heap) const {
+        if (begin >= end) {
+            return;
+        }
+        const size_t middle = begin + (end - begin) / 2;
+        const double chord_square = ComputeChordSquare(points_[middle], point);
+        if (heap.size() < count || chord_square < heap.front().first) {
+            heap.emplace_back(chord_square, middle);
+            std::push_heap(heap.begin(), heap.end());
+            if (heap.size() > count) {
+                std::pop_heap(heap.begin(), heap.end());
+                heap.pop_back();
+            }
+        }
+
+        const size_t axis = depth % 3;
+        const double diff = point.coordinates[axis] - points_[middle].coordinates[axis];
+        const bool is_left_first = diff < 0;
+        if (is_left_first) {
+            SearchNearest(begin, middle, depth + 1, point, count, heap);
+        } else {
+            SearchNearest(middle + 1, end, depth + 1, point, count, heap);
+        }
+        if (heap.size() < count || diff * diff < heap.front().first) {
+            if (is_left_first) {
+                SearchNearest(middle + 1, end, depth + 1, point, count, heap);
+            } else {
+                SearchNearest(begin, middle, depth + 1, point, count, heap);
+            }
+        }
+    }
+
+    void StopSpatialIndex::SearchWithinChord(size_t begin, size_t end, size_t depth, const Point& point,
+                                             double chord_square, std::vector<Candidate>& result) const {
+        if (begin >= end) {
+            return;
+        }
+        const size_t middle = begin + (end - begin) / 2;
+        const double middle_chord_square = ComputeChordSquare(points_[middle], point);
+        if (middle_chord_square <= chord_square) {
+            result.emplace_back(middle_chord_square, middle);
+        }
+
+        const size_t axis = depth % 3;
+        const double diff = point.coordinates[axis] - points_[middle].coordinates[axis];
+        if (diff < 0 || diff * diff <= chord_square) {
+            SearchWithinChord(begin, middle, depth + 1, point, chord_square, result);
+        }
+        if (diff >= 0 || diff * diff <= chord_square) {
+            SearchWithinChord(middle + 1, end, depth + 1, point, chord_square, result);
+        }
+    }
+
+    void StopSpatialIndex::SearchInBounds(size_t begin, size_t end, size_t depth, const std::pair<Point, Point>& bounds,
+                                          const GeoBox& box, std::vector<domain::StopId>& result) const {
+        if (begin >= end) {
+            return;
+        }
+        const size_t middle = begin + (end - begin) / 2;
+        const Point& point = points_[middle];
+        bool is_inside = true;
+        for (size_t axis = 0; axis < 3; ++axis) {
+            is_inside = is_inside && bounds.first.coordinates[axis] <= point.coordinates[axis]
+                        && point.coordinates[axis] <= bounds.second.coordinates[axis];
+        }
+        if (is_inside && box.Contains(coordinates_[middle])) {
+            result.push_back(order_[middle]);
+        }
+
+        const size_t axis = depth % 3;
+        if (bounds.first.coordinates[axis] <= point.coordinates[axis]) {
+            SearchInBounds(begin, middle, depth + 1, bounds, box, result);
+        }
+        if (bounds.second.coordinates[axis] >= point.coordinates[axis]) {
+            SearchInBounds(middle + 1, end, depth + 1, bounds, box, result);
+        }
+    }
+
+    std::vector<StopSpatialIndex::Neighbour> StopSpatialIndex::RankByDistance(geo::Coordinates point,
+                                                                              const std::vector<Candidate>& candidates) const {
+        // Равные расстояния различаются по хорде: она точнее для близких точек
+        std::vector<std::pair<Neighbour, double>> ranked;
+        ranked.reserve(candidates.size());
+        for (const auto& [chord_square, position] : candidates) {
+            ranked.push_back({{order_[position], geo::ComputeDistance(point, coordinates_[position])}, chord_square});
+        }
+        std::sort(ranked.begin(), ranked.end(), [](const auto& lhs, const auto& rhs) {
+            return std::tie(lhs.first.distance, lhs.second, lhs.first.stop)
+                   < std::tie(rhs.first.distance, rhs.second, rhs.first.stop);
+        });
+        std::vector<Neighbour> result;
+        result.reserve(ranked.size());
+        for (const auto& [neighbour, chord_square] : ranked) {
+            result.push_back(neighbour);
+        }
+        return result;
+    }
+
+    //-------- RouteBoundsIndex --------
+
+    RouteBoundsIndex::RouteBoundsIndex(const TransportCatalogue& catalogue) {
+        const auto& buses = catalogue.GetBuses();
+        std::vector<GeoBox> bounds_by_bus(buses.size());
+        for (const domain::Bus& bus : buses) {
+            if (bus.stops.empty()) {
+                continue;
+            }
+            GeoBox& bounds = bounds_by_bus[bus.id];
+            bounds.min = bounds.max = catalogue.GetStop(bus.stops.front()).coordinates;
+            for (const domain::StopId stop : bus.stops) {
+                bounds.Extend(catalogue.GetStop(stop).coordinates);
+            }
+            order_.push_back(bus.id);
+        }
+        subtree_bounds_.resize(order_.size());
+        if (!order_.empty()) {
+            Build(0, order_.size(), 0, bounds_by_bus);
+        }
+
+        route_bounds_.reserve(order_.size());
+        offsets_.reserve(order_.size() + 1);
+        offsets_.push_back(0);
+        for (const domain::BusId bus : order_) {
+            route_bounds_.push_back(bounds_by_bus[bus]);
+            for (const domain::StopId stop : catalogue.GetRouteStops(bus)) {
+                route_points_.push_back(catalogue.GetStop(stop).coordinates);
+            }
+            offsets_.push_back(route_points_.size());
+        }
+    }
+
+    std::vector<domain::BusId> RouteBoundsIndex::FindCrossing(const GeoBox& box) const {
+        std::vector<domain::BusId> result;
+        // Отрезок проверяется по границам, упорядоченным по каждой оси, и пересёк бы перевёрнутый прямоугольник
+        if (box.IsEmpty()) {
+            return result;
+        }
+        Search(0, order_.size(), box, result);
+        return result;
+    }
+
+    GeoBox RouteBoundsIndex::Build(size_t begin, size_t end, size_t depth, const std::vector<GeoBox>& bounds_by_bus) {
+        const size_t middle = begin + (end - begin) / 2;
+        const bool is_lat_axis = depth % 2 == 0;
+        const auto center = [&bounds_by_bus, is_lat_axis](domain::BusId bus) {
+            const GeoBox& bounds = bounds_by_bus[bus];
+            return is_lat_axis ? bounds.min.lat + bounds.max.lat : bounds.min.lng + bounds.max.lng;
+        };
+        std::nth_element(order_.begin() + begin, order_.begin() + middle, order_.begin() + end,
+                         [&center](domain::BusId lhs, domain::BusId rhs) {
+            return center(lhs) < center(rhs);
+        });
+        GeoBox subtree_bounds = bounds_by_bus[order_[middle]];
+        if (begin < middle) {
+            subtree_bounds.Extend(Build(begin, middle, depth + 1, bounds_by_bus));
+        }
+        if (middle + 1 < end) {
+            subtree_bounds.Extend(Build(middle + 1, end, depth + 1, bounds_by_bus));
+        }
+        return subtree_bounds_[middle] = subtree_bounds;
+    }
+
+    void RouteBoundsIndex::Search(size_t begin, size_t end, const GeoBox& box,
+                                  std::vector<domain::BusId>& result) const {
+        if (begin >= end) {
+            return;
+        }
+        const size_t middle = begin + (end - begin) / 2;
+        if (!subtree_bounds_[middle].Intersects(box)) {
+            return;
+        }
+        if (route_bounds_[middle].Intersects(box) && IsCrossing(middle, box)) {
+            result.push_back(order_[middle]);
+        }
+        Search(begin, middle, box, result);
+        Search(middle + 1, end, box, result);
+    }
+
+    bool RouteBoundsIndex::IsCrossing(size_t position, const GeoBox& box) const {
+        const size_t begin = offsets_[position];
+        const size_t end = offsets_[position + 1];
+        if (end - begin == 1) {
+            return box.Contains(route_points_[begin]);
+        }
+        for (size_t i = begin + 1; i < end; ++i) {
+            if (IsSegmentCrossing(route_points_[i - 1], route_points_[i], box)) {
+                return true;
+            }
+        }
+        return false;
+    }
+}  // namespace transport_catalogue::spatial
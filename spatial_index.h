@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "domain.h"
+#include "geo.h"
+#include "transport_catalogue.h"
+
+namespace transport_catalogue::spatial {
+
+    // Прямоугольник на карте: широты от min.lat до max.lat, долготы от min.lng до max.lng
+    struct GeoBox {
+        // Прямоугольник пуст, если минимум больше максимума хотя бы по одной оси
+        [[nodiscard]] bool IsEmpty() const;
+        [[nodiscard]] bool Contains(geo::Coordinates point) const;
+        [[nodiscard]] bool Intersects(const GeoBox& other) const;
+        void Extend(geo::Coordinates point);
+        void Extend(const GeoBox& other);
+
+        geo::Coordinates min;
+        geo::Coordinates max;
+    };
+
+    // Статический индекс остановок для поиска ближайших к точке. Координаты переводятся в точки единичной сферы:
+    // длина хорды монотонна по расстоянию вдоль поверхности, поэтому поиск по хордам находит тех же соседей.
+    // Точки хранятся неявным KD-деревом: корень поддерева [begin, end) лежит в середине диапазона,
+    // ось разбиения чередуется по глубине. Порядок остановок в дереве сохраняется в базе
+    class StopSpatialIndex {
+    public:
+        struct Neighbour {
+            domain::StopId stop;
+            double distance;  // метры, geo::ComputeDistance
+        };
+
+        StopSpatialIndex() = default;
+        explicit StopSpatialIndex(const TransportCatalogue& catalogue);
+        // Восстанавливает индекс по сохранённому порядку. Если порядок не соответствует остановкам справочника,
+        // индекс строится заново
+        StopSpatialIndex(const TransportCatalogue& catalogue, std::vector<domain::StopId> order);
+
+        // count ближайших остановок по возрастанию расстояния
+        [[nodiscard]] std::vector<Neighbour> FindNearest(geo::Coordinates point, size_t count) const;
+        // Остановки не дальше radius метров по возрастанию расстояния, не больше max_count
+        [[nodiscard]] std::vector<Neighbour> FindWithinRadius(geo::Coordinates point, double radius,
+                                                              size_t max_count = std::numeric_limits<size_t>::max()) const;
+        // Остановки внутри прямоугольника в порядке дерева
+        [[nodiscard]] std::vector<domain::StopId> FindInBox(const GeoBox& box) const;
+
+        [[nodiscard]] const std::vector<domain::StopId>& GetOrder() const;
+
+    private:
+        struct Point {
+            double coordinates[3];
+        };
+        // Кандидат поиска: квадрат хорды и позиция в дереве
+        using Candidate = std::pair<double, size_t>;
+
+        static Point ToPoint(geo::Coordinates coordinates);
+        // Наименьший прямоугольный параллелепипед, содержащий точки сферы из прямоугольника на карте
+        static std::pair<Point, Point> ToPointBounds(const GeoBox& box);
+        static double ComputeChordSquare(const Point& lhs, const Point& rhs);
+
+        void Build(size_t begin, size_t end, size_t depth, std::vector<Point>& points_by_stop);
+        void FillPoints(const TransportCatalogue& catalogue);
+        void SearchNearest(size_t begin, size_t end, size_t depth, const Point& point, size_t count,
+                           std::vector<Candidate>& heap) const;
+        void SearchWithinChord(size_t begin, size_t end, size_t depth, const Point& point, double chord_square,
+                               std::vector<Candidate>& result) const;
+        void SearchInBounds(size_t begin, size_t end, size_t depth, const std::pair<Point, Point>& bounds,
+                            const GeoBox& box, std::vector<domain::StopId>& result) const;
+        // Кандидаты по возрастанию geo::ComputeDistance до точки
+        [[nodiscard]] std::vector<Neighbour> RankByDistance(geo::Coordinates point,
+                                                            const std::vector<Candidate>& candidates) const;
+
+        std::vector<domain::StopId> order_;
+        // Точки и координаты остановок в порядке order_
+        std::vector<Point> points_;
+        std::vector<geo::Coordinates> coordinates_;
+    };
+
+    // Статический индекс линий маршрутов для поиска маршрутов, проходящих через прямоугольник на карте.
+    // Маршруты хранятся неявной иерархией ограничивающих прямоугольников: корень поддерева [begin, end) лежит
+    // в середине диапазона, маршруты делятся по центрам своих прямоугольников, ось чередуется по глубине.
+    // Отрезки между остановками считаются прямыми в координатах широта-долгота
+    class RouteBoundsIndex {
+    public:
+        RouteBoundsIndex() = default;
+        explicit RouteBoundsIndex(const TransportCatalogue& catalogue);
+
+        // Автобусы, линия маршрута которых проходит через прямоугольник, в порядке индекса
+        [[nodiscard]] std::vector<domain::BusId> FindCrossing(const GeoBox& box) const;
+
+    private:
+        GeoBox Build(size_t begin, size_t end, size_t depth, const std::vector<GeoBox>& bounds_by_bus);
+        void Search(size_t begin, size_t end, const GeoBox& box, std::vector<domain::BusId>& result) const;
+        [[nodiscard]] bool IsCrossing(size_t position, const GeoBox& box) const;
+
+        std::vector<domain::BusId> order_;
+        // Прямоугольник маршрута и поддерева с корнем в позиции, в порядке order_
+        std::vector<GeoBox> route_bounds_;
+        std::vector<GeoBox> subtree_bounds_;
+        // Координаты остановок маршрутов подряд; линия маршрута в позиции i - [offsets_[i], offsets_[i + 1])
+        std::vector<geo::Coordinates> route_points_;
+        std::vector<size_t> offsets_;
+    };
+}  // namespace transport_catalogue::spatial
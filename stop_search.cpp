@@ -0,0 +1,267 @@
+#include <algorithm>
+#include <functional>
+
+#include "stop_search.h"
+
+namespace transport_catalogue::search {
+    namespace {
+        // Символ строки UTF-8, начинающийся со смещения offset, и его длина в байтах.
+        // Байт, с которого не начинается корректный символ, считается отдельным символом
+        size_t DecodeSymbol(std::string_view str, size_t offset, char32_t& symbol) {
+            const auto lead = static_cast<unsigned char>(str[offset]);
+            size_t length = lead < 0x80 ? 1
+                    : (lead >> 5) == 0x6 ? 2
+                    : (lead >> 4) == 0xE ? 3
+                    : (lead >> 3) == 0x1E ? 4
+                    : 1;
+            if (offset + length > str.size()) {
+                length = 1;
+            }
+            symbol = length == 1 ? lead : lead & (0x7F >> length);
+            for (size_t i = 1; i < length; ++i) {
+                const auto next = static_cast<unsigned char>(str[offset + i]);
+                if ((next >> 6) != 0x2) {
+                    symbol = lead;
+                    return 1;
+                }
+                symbol = (symbol << 6) | (next & 0x3F);
+            }
+            return length;
+        }
+
+        std::vector<char32_t> DecodeUtf8(std::string_view str) {
+            std::vector<char32_t> result;
+            for (size_t offset = 0; offset < str.size();) {
+                char32_t symbol;
+                offset += DecodeSymbol(str, offset, symbol);
+                result.push_back(symbol);
+            }
+            return result;
+        }
+
+        // Остановка в позиции lhs идёт в ответе раньше остановки в позиции rhs: через неё проходит больше автобусов
+        // или столько же, но её название меньше
+        bool IsBetter(const std::vector<uint32_t>& bus_counts, size_t lhs, size_t rhs) {
+            return bus_counts[lhs] > bus_counts[rhs] || (bus_counts[lhs] == bus_counts[rhs] && lhs < rhs);
+        }
+
+        // Отбирает count лучших позиций из добавленных по одной
+        class TopStops {
+        public:
+            TopStops(const std::vector<uint32_t>& bus_counts, size_t count)
+                : bus_counts_(bus_counts)
+                , count_(count) {
+            }
+
+            void Add(size_t position) {
+                const auto is_better = [this](size_t lhs, size_t rhs) {
+                    return IsBetter(bus_counts_, lhs, rhs);
+                };
+                if (heap_.size() < count_) {
+                    heap_.push_back(position);
+                    std::push_heap(heap_.begin(), heap_.end(), is_better);
+                } else if (count_ > 0 && is_better(position, heap_.front())) {
+                    // В вершине кучи - худшая из отобранных позиций
+                    std::pop_heap(heap_.begin(), heap_.end(), is_better);
+                    heap_.back() = position;
+                    std::push_heap(heap_.begin(), heap_.end(), is_better);
+                }
+            }
+
+            // Отобранные позиции, начиная с лучшей
+            std::vector<size_t> Take() {
+                std::sort_heap(heap_.begin(), heap_.end(), [this](size_t lhs, size_t rhs) {
+                    return IsBetter(bus_counts_, lhs, rhs);
+                });
+                return std::move(heap_);
+            }
+
+        private:
+            const std::vector<uint32_t>& bus_counts_;
+            const size_t count_;
+            std::vector<size_t> heap_;
+        };
+    }
+
+    StopNameIndex::StopNameIndex(const TransportCatalogue& catalogue) {
+        const auto& stops = catalogue.GetStops();
+        order_.reserve(stops.size());
+        for (const domain::Stop& stop : stops) {
+            order_.push_back(stop.id);
+        }
+        std::sort(order_.begin(), order_.end(), [&stops](domain::StopId lhs, domain::StopId rhs) {
+            return stops[lhs].name < stops[rhs].name;
+        });
+        FillNames(catalogue);
+    }
+
+    StopNameIndex::StopNameIndex(const TransportCatalogue& catalogue, std::vector<domain::StopId> order)
+        : order_(std::move(order)) {
+        std::vector<bool> is_seen(catalogue.GetStops().size());
+        const bool is_permutation = order_.size() == is_seen.size()
+                                    && std::all_of(order_.begin(), order_.end(), [&is_seen](domain::StopId stop) {
+            if (stop >= is_seen.size() || is_seen[stop]) {
+                return false;
+            }
+            is_seen[stop] = true;
+            return true;
+        });
+        if (is_permutation) {
+            FillNames(catalogue);
+        }
+        // Названия остановок различны, поэтому в правильном порядке строго возрастают
+        if (!is_permutation || std::adjacent_find(names_.begin(), names_.end(), std::greater_equal<>{}) != names_.end()) {
+            *this = StopNameIndex(catalogue);
+        }
+    }
+
+    // Лучшая позиция диапазона находится по дереву отрезков, после чего диапазон делится на части слева и справа
+    // от неё. Очередь частей упорядочена по их лучшим позициям, поэтому позиции извлекаются в порядке ответа
+    std::vector<FoundStop> StopNameIndex::FindByPrefix(std::string_view prefix, size_t count) const {
+        const size_t begin = std::lower_bound(names_.begin(), names_.end(), prefix) - names_.begin();
+        const size_t end = FindPrefixEnd(begin, prefix);
+
+        struct Part {
+            size_t best;
+            size_t begin;
+            size_t end;
+        };
+        const auto is_worse = [this](const Part& lhs, const Part& rhs) {
+            return IsBetter(bus_counts_, rhs.best, lhs.best);
+        };
+        std::vector<Part> parts;
+        const auto add_part = [&](size_t part_begin, size_t part_end) {
+            if (part_begin < part_end) {
+                parts.push_back({FindBest(part_begin, part_end), part_begin, part_end});
+                std::push_heap(parts.begin(), parts.end(), is_worse);
+            }
+        };
+
+        std::vector<size_t> positions;
+        add_part(begin, end);
+        while (positions.size() < count && !parts.empty()) {
+            std::pop_heap(parts.begin(), parts.end(), is_worse);
+            const Part part = parts.back();
+            parts.pop_back();
+            positions.push_back(part.best);
+            add_part(part.begin, part.best);
+            add_part(part.best + 1, part.end);
+        }
+        return MakeResult(positions);
+    }
+
+    // Обход неявного префиксного дерева. Строка depth таблицы расстояний - расстояния от первых depth символов
+    // названия до всех начал запроса. Строки общего начала соседних названий не пересчитываются, а ветвь,
+    // в строке которой все расстояния больше max_distance, пропускается целиком
+    std::vector<FoundStop> StopNameIndex::FindSimilar(std::string_view query, size_t max_distance,
+                                                      size_t count) const {
+        max_distance = std::min(max_distance, MAX_EDIT_DISTANCE);
+        const std::vector<char32_t> query_chars = DecodeUtf8(query);
+        const size_t width = query_chars.size() + 1;
+
+        std::vector<size_t> rows(width);
+        for (size_t column = 0; column < width; ++column) {
+            rows[column] = column;
+        }
+        // Путь в дереве - первые символы названия path_name, для которых посчитаны строки таблицы.
+        // path_ends[depth] - длина первых depth символов в байтах
+        std::string_view path_name;
+        std::vector<size_t> path_ends{0};
+        TopStops top(bus_counts_, count);
+        size_t position = 0;
+        while (position < names_.size()) {
+            const std::string_view name = names_[position];
+            // Символы пути совпадают с символами названия, пока совпадают их байты
+            const size_t common_bytes = std::mismatch(path_name.begin(), path_name.begin() + path_ends.back(),
+                                                      name.begin(), name.end()).first - path_name.begin();
+            size_t depth = std::upper_bound(path_ends.begin(), path_ends.end(), common_bytes) - path_ends.begin() - 1;
+            path_ends.resize(depth + 1);
+            path_name = name;
+
+            bool is_pruned = false;
+            while (path_ends[depth] < name.size()) {
+                char32_t symbol;
+                path_ends.push_back(path_ends[depth] + DecodeSymbol(name, path_ends[depth], symbol));
+                rows.resize((depth + 2) * width);
+                const size_t* previous = rows.data() + depth * width;
+                size_t* current = rows.data() + (depth + 1) * width;
+                current[0] = depth + 1;
+                size_t row_min = current[0];
+                for (size_t column = 1; column < width; ++column) {
+                    const size_t substitution = previous[column - 1] + (symbol == query_chars[column - 1] ? 0 : 1);
+                    current[column] = std::min({previous[column] + 1, current[column - 1] + 1, substitution});
+                    row_min = std::min(row_min, current[column]);
+                }
+                ++depth;
+                if (row_min > max_distance) {
+                    is_pruned = true;
+                    break;
+                }
+            }
+            if (is_pruned) {
+                position = FindPrefixEnd(position, name.substr(0, path_ends[depth]));
+            } else {
+                if (rows[depth * width + width - 1] <= max_distance) {
+                    top.Add(position);
+                }
+                ++position;
+            }
+        }
+        return MakeResult(top.Take());
+    }
+
+    const std::vector<domain::StopId>& StopNameIndex::GetOrder() const {
+        return order_;
+    }
+
+    void StopNameIndex::FillNames(const TransportCatalogue& catalogue) {
+        names_.reserve(order_.size());
+        bus_counts_.reserve(order_.size());
+        for (const domain::StopId stop : order_) {
+            names_.push_back(catalogue.GetStop(stop).name);
+            bus_counts_.push_back(static_cast<uint32_t>(catalogue.GetBusesAtStop(stop).size()));
+        }
+
+        // Листья дерева отрезков лежат в позициях [size, 2 * size), родитель узла node - в позиции node / 2
+        const size_t size = order_.size();
+        best_in_segment_.resize(2 * size);
+        for (size_t position = 0; position < size; ++position) {
+            best_in_segment_[size + position] = static_cast<uint32_t>(position);
+        }
+        for (size_t node = size - 1; node > 0 && size > 0; --node) {
+            const uint32_t left = best_in_segment_[2 * node];
+            const uint32_t right = best_in_segment_[2 * node + 1];
+            best_in_segment_[node] = IsBetter(bus_counts_, left, right) ? left : right;
+        }
+    }
+
+    size_t StopNameIndex::FindPrefixEnd(size_t begin, std::string_view prefix) const {
+        return std::partition_point(names_.begin() + begin, names_.end(), [prefix](std::string_view name) {
+            return name.substr(0, prefix.size()) == prefix;
+        }) - names_.begin();
+    }
+
+    size_t StopNameIndex::FindBest(size_t begin, size_t end) const {
+        size_t best = begin;
+        for (size_t left = begin + order_.size(), right = end + order_.size(); left < right; left /= 2, right /= 2) {
+            if (left % 2 == 1) {
+                const size_t candidate = best_in_segment_[left++];
+                best = IsBetter(bus_counts_, candidate, best) ? candidate : best;
+            }
+            if (right % 2 == 1) {
+                const size_t candidate = best_in_segment_[--right];
+                best = IsBetter(bus_counts_, candidate, best) ? candidate : best;
+            }
+        }
+        return best;
+    }
+
+    std::vector<FoundStop> StopNameIndex::MakeResult(const std::vector<size_t>& positions) const {
+        std::vector<FoundStop> result;
+        result.reserve(positions.size());
+        for (const size_t position : positions) {
+            result.push_back({order_[position], bus_counts_[position]});
+        }
+        return result;
+    }
+}  // namespace transport_catalogue::search
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "domain.h"
+#include "transport_catalogue.h"
+
+namespace transport_catalogue::search {
+
+    // Найденная остановка и число автобусов, которые через неё проходят
+    struct FoundStop {
+        domain::StopId stop;
+        size_t bus_count;
+    };
+
+    // Статический индекс названий остановок для поиска по началу названия и по названию с опечатками.
+    // Номера остановок хранятся по возрастанию названий: остановки с общим началом названия идут подряд,
+    // и массив служит неявным префиксным деревом. Порядок остановок сохраняется в базе.
+    // Названия сравниваются побайтно с учётом регистра, расстояние редактирования считается по символам UTF-8.
+    // Найденные остановки упорядочены по убыванию числа автобусов, при равенстве - по возрастанию названий
+    class StopNameIndex {
+    public:
+        // Наибольшее расстояние редактирования при поиске с опечатками: с ним поиск отсекает почти все ветви дерева
+        static constexpr size_t MAX_EDIT_DISTANCE = 2;
+
+        StopNameIndex() = default;
+        explicit StopNameIndex(const TransportCatalogue& catalogue);
+        // Восстанавливает индекс по сохранённому порядку. Если порядок не соответствует остановкам справочника,
+        // индекс строится заново
+        StopNameIndex(const TransportCatalogue& catalogue, std::vector<domain::StopId> order);
+
+        // Не больше count остановок, название которых начинается с prefix
+        [[nodiscard]] std::vector<FoundStop> FindByPrefix(std::string_view prefix, size_t count) const;
+        // Не больше count остановок, название которых получается из query не больше чем max_distance вставками,
+        // удалениями и заменами символов. max_distance ограничивается MAX_EDIT_DISTANCE
+        [[nodiscard]] std::vector<FoundStop> FindSimilar(std::string_view query, size_t max_distance,
+                                                         size_t count) const;
+
+        [[nodiscard]] const std::vector<domain::StopId>& GetOrder() const;
+
+    private:
+        void FillNames(const TransportCatalogue& catalogue);
+        // Конец диапазона названий, начинающихся с prefix, который начинается в позиции begin
+        [[nodiscard]] size_t FindPrefixEnd(size_t begin, std::string_view prefix) const;
+        // Позиция лучшей остановки в непустом диапазоне позиций [begin, end)
+        [[nodiscard]] size_t FindBest(size_t begin, size_t end) const;
+        [[nodiscard]] std::vector<FoundStop> MakeResult(const std::vector<size_t>& positions) const;
+
+        std::vector<domain::StopId> order_;
+        // Названия и число автобусов остановок в порядке order_
+        std::vector<std::string_view> names_;
+        std::vector<uint32_t> bus_counts_;
+        // Дерево отрезков по позициям: в узле - позиция лучшей остановки его отрезка
+        std::vector<uint32_t> best_in_segment_;
+    };
+}  // namespace transport_catalogue::search
@@ -1,96 +1,416 @@
 #include <algorithm>
 #include <iostream>
+#include <numeric>
+#include <stdexcept>
 #include <vector>
-#include <unordered_set>
 
+#include "parallel.h"
 #include "transport_catalogue.h"
 
 namespace transport_catalogue {
+    namespace {
+        using RoadDistanceIt = std::vector<TransportCatalogue::RoadDistance>::iterator;
 
-    void TransportCatalogue::AddRoute(std::string_view bus_number, const std::vector<std::string> &stops,
-                                      bool is_roundtrip) {
-        int stops_on_route = stops.size();
-        int unique_stops = std::unordered_set<std::string_view>{stops.begin(), stops.end()}.size();
-        double geographic_distance = 0;
-        int route_length = 0;
-        if (stops.size() > 1) {
-            for (auto it = stops.begin(); it < stops.end() - 1; ++it) {
-                Stop *from = FindStop(*it);
-                Stop *to = FindStop(*(it + 1));
-                geographic_distance += ComputeDistance(from->coordinates, to->coordinates);
-                route_length += FindDistanceBetweenStops(from->name, to->name);
+        // Сортирует расстояния остановки по номеру соседа и оставляет по одному на соседа:
+        // последнее явно заданное, а если таких нет - последнее взятое из обратного направления.
+        // Возвращает конец оставшихся расстояний
+        RoadDistanceIt CollapseDistances(RoadDistanceIt begin, RoadDistanceIt end) {
+            using RoadDistance = TransportCatalogue::RoadDistance;
+            std::stable_sort(begin, end, [](const RoadDistance& lhs, const RoadDistance& rhs) {
+                return lhs.to < rhs.to;
+            });
+            auto result_end = begin;
+            for (auto group_begin = begin; group_begin != end;) {
+                const auto group_end = std::find_if(group_begin, end, [group_begin](const RoadDistance& item) {
+                    return item.to != group_begin->to;
+                });
+                auto chosen = group_end - 1;
+                for (auto it = group_end; it != group_begin;) {
+                    if ((--it)->is_explicit) {
+                        chosen = it;
+                        break;
+                    }
+                }
+                *result_end++ = *chosen;
+                group_begin = group_end;
             }
+            return result_end;
         }
-        buses_.push_back({std::string{bus_number}, stops_on_route, unique_stops, route_length,
-                          route_length / geographic_distance, is_roundtrip});
-        pointer_to_buses_[buses_.back().number] = &buses_.back();
-        for (std::string_view str : stops) {
-            buses_at_stops_[FindStop(str)].insert(buses_.back().number);
-            routes_[buses_.back().number].push_back(FindStop(str)->name);
+    }
+
+    void TransportCatalogue::AddRoute(std::string_view bus_number, const std::vector<std::string> &stops,
+                                      bool is_roundtrip) {
+        AddRoute(bus_number, FindStopIds({stops.begin(), stops.end()}), is_roundtrip);
+    }
+
+    domain::BusId TransportCatalogue::AddRoute(std::string_view bus_number, std::vector<StopId> stops,
+                                               bool is_roundtrip) {
+        if (std::any_of(stops.begin(), stops.end(), [this](StopId stop) { return stop >= stops_.size(); })) {
+            throw std::out_of_range("Unknown stop in bus " + std::string(bus_number));
         }
+        const BusId bus_id = AppendBus(bus_number, std::move(stops), is_roundtrip);
+        ComputeRouteStats(buses_[bus_id]);
+        return bus_id;
     }
 
-    void TransportCatalogue::AddStop(std::string_view stop_name, const geo::Coordinates &coordinates) {
-        stops_.push_back({std::string{stop_name}, coordinates});
-        pointer_to_stops_[stops_.back().name] = &stops_.back();
-        if (!buses_at_stops_.count(&stops_.back())) {
-            buses_at_stops_[&stops_.back()];
+    domain::StopId TransportCatalogue::AddStop(std::string_view stop_name, const geo::Coordinates &coordinates) {
+        const auto stop_id = static_cast<StopId>(stops_.size());
+        stops_.push_back({names_.Intern(stop_name), coordinates, stop_id});
+        if (stop_hash_.IsEmpty()) {
+            stop_ids_.Add(stops_.back().name, stop_id);
         }
+        is_buses_at_stops_indexed_ = false;
+        if (road_distances_offsets_.empty()) {
+            road_distances_offsets_.push_back(0);
+        }
+        road_distances_offsets_.push_back(road_distances_.size());
+        return stop_id;
     }
 
     void TransportCatalogue::AddDistanceBetweenStops(std::string_view from_stop_name, std::string_view to_stop_name,
                                                      double distance) {
-        std::pair pair_stops{FindStop(from_stop_name), FindStop(to_stop_name)};
-        distance_between_stops_[pair_stops] = distance;
+        AddDistanceBetweenStops(FindStopId(from_stop_name), FindStopId(to_stop_name), static_cast<int>(distance));
     }
 
-    domain::Bus *TransportCatalogue::FindRoute(std::string_view bus_name) const {
-        auto found_bus = pointer_to_buses_.find(bus_name);
-        if (found_bus != pointer_to_buses_.end()) {
-            return found_bus->second;
-        } else {
-            return nullptr;
+    // Обратное направление получает то же расстояние, пока для него не задано своё,
+    // поэтому при поиске не нужно проверять пару в обе стороны
+    void TransportCatalogue::AddDistanceBetweenStops(StopId from_stop, StopId to_stop, int distance) {
+        SetDistance(from_stop, to_stop, distance, true);
+        SetDistance(to_stop, from_stop, distance, false);
+    }
+
+    void TransportCatalogue::AddBase(const BaseInput<std::string_view>& base) {
+        AddStops(base.stops);
+
+        // Названия из расстояний и маршрутов разрешаются одним пакетом: сначала расстояния, затем остановки маршрутов
+        std::vector<std::string_view> stop_names;
+        stop_names.reserve(base.distances.size() * 2);
+        for (const auto& distance : base.distances) {
+            stop_names.push_back(distance.from_stop);
+            stop_names.push_back(distance.to_stop);
         }
+        for (const auto& bus : base.buses) {
+            stop_names.insert(stop_names.end(), bus.stops.begin(), bus.stops.end());
+        }
+        const std::vector<StopId> stop_ids = FindStopIds(stop_names);
+
+        BaseInput<StopId> resolved;
+        auto next_stop_id = stop_ids.begin();
+        resolved.distances.reserve(base.distances.size());
+        for (const auto& distance : base.distances) {
+            resolved.distances.push_back({*next_stop_id, *(next_stop_id + 1), distance.distance});
+            next_stop_id += 2;
+        }
+        resolved.buses.reserve(base.buses.size());
+        for (const auto& bus : base.buses) {
+            resolved.buses.push_back({bus.number, {next_stop_id, next_stop_id + bus.stops.size()}, bus.is_roundtrip,
+                                      bus.stats});
+            next_stop_id += bus.stops.size();
+        }
+        AddDistancesAndBuses(std::move(resolved));
     }
 
-    domain::Stop *TransportCatalogue::FindStop(std::string_view stop_name) const {
-        auto found_stop = pointer_to_stops_.find(stop_name);
-        if (found_stop != pointer_to_stops_.end()) {
-            return found_stop->second;
-        } else {
-            return nullptr;
+    void TransportCatalogue::AddBase(BaseInput<StopId> base) {
+        AddStops(base.stops);
+        AddDistancesAndBuses(std::move(base));
+    }
+
+    const domain::Bus *TransportCatalogue::FindRoute(std::string_view bus_name) const {
+        const BusId bus_id = FindBusId(bus_name);
+        return bus_id == domain::NO_ID ? nullptr : &buses_[bus_id];
+    }
+
+    const domain::Stop *TransportCatalogue::FindStop(std::string_view stop_name) const {
+        const StopId stop_id = FindStopId(stop_name);
+        return stop_id == domain::NO_ID ? nullptr : &stops_[stop_id];
+    }
+
+    void TransportCatalogue::SetNameHashes(domain::PerfectHash stop_hash, domain::PerfectHash bus_hash) {
+        stop_hash_ = std::move(stop_hash);
+        bus_hash_ = std::move(bus_hash);
+    }
+
+    domain::StopId TransportCatalogue::FindStopId(std::string_view stop_name) const {
+        if (!stop_hash_.IsEmpty()) {
+            const StopId stop_id = stop_hash_.Find(stop_name);
+            return stop_id < stops_.size() && stops_[stop_id].name == stop_name ? stop_id : domain::NO_ID;
         }
+        const StopId* found_stop = stop_ids_.Find(stop_name);
+        return found_stop ? *found_stop : domain::NO_ID;
     }
 
-    const std::set<std::string_view> &TransportCatalogue::FindBusesAtStops(std::string_view stop_name) const {
-        static const std::set<std::string_view> empty_set;
-        const auto found_buses = buses_at_stops_.find(FindStop(stop_name));
-        if (found_buses != buses_at_stops_.end()) {
-            return found_buses->second;
-        } else {
-            return empty_set;
+    domain::BusId TransportCatalogue::FindBusId(std::string_view bus_name) const {
+        if (!bus_hash_.IsEmpty()) {
+            const BusId bus_id = bus_hash_.Find(bus_name);
+            return bus_id < buses_.size() && buses_[bus_id].number == bus_name ? bus_id : domain::NO_ID;
+        }
+        const BusId* found_bus = bus_ids_.Find(bus_name);
+        return found_bus ? *found_bus : domain::NO_ID;
+    }
+
+    // Автобусы обходятся по возрастанию названий, поэтому список каждой остановки получается отсортированным.
+    // Повтор остановки в маршруте отсекается сравнением с последним добавленным автобусом
+    void TransportCatalogue::IndexBusesAtStops() {
+        const std::vector<BusId> bus_ids = GetBusIdsByName();
+        buses_at_stops_offsets_.assign(stops_.size() + 1, 0);
+        std::vector<BusId> last_bus(stops_.size(), domain::NO_ID);
+        for (const BusId bus_id : bus_ids) {
+            for (const StopId stop : buses_[bus_id].stops) {
+                if (last_bus[stop] != bus_id) {
+                    last_bus[stop] = bus_id;
+                    ++buses_at_stops_offsets_[stop + 1];
+                }
+            }
+        }
+        for (size_t stop = 1; stop < buses_at_stops_offsets_.size(); ++stop) {
+            buses_at_stops_offsets_[stop] += buses_at_stops_offsets_[stop - 1];
+        }
+
+        buses_at_stops_.resize(buses_at_stops_offsets_.back());
+        std::vector<size_t> next_positions(buses_at_stops_offsets_.begin(), buses_at_stops_offsets_.end() - 1);
+        last_bus.assign(stops_.size(), domain::NO_ID);
+        for (const BusId bus_id : bus_ids) {
+            for (const StopId stop : buses_[bus_id].stops) {
+                if (last_bus[stop] != bus_id) {
+                    last_bus[stop] = bus_id;
+                    buses_at_stops_[next_positions[stop]++] = bus_id;
+                }
+            }
+        }
+        is_buses_at_stops_indexed_ = true;
+    }
+
+    TransportCatalogue::BusIdRange TransportCatalogue::FindBusesAtStops(std::string_view stop_name) const {
+        const StopId stop_id = FindStopId(stop_name);
+        if (stop_id == domain::NO_ID) {
+            return {buses_at_stops_.end(), buses_at_stops_.end()};
         }
+        return GetBusesAtStop(stop_id);
     }
 
     int TransportCatalogue::FindDistanceBetweenStops(std::string_view from_stop, std::string_view to_stop) const {
-        Stop *pointer_from_stop = FindStop(from_stop);
-        Stop *pointer_to_stop = FindStop(to_stop);
-        if (distance_between_stops_.count(std::pair(pointer_from_stop, pointer_to_stop)) > 0) {
-            return distance_between_stops_.at(std::pair(pointer_from_stop, pointer_to_stop));
-        } else {
-            return distance_between_stops_.at(std::pair(pointer_to_stop, pointer_from_stop));
+        return GetDistance(FindStopId(from_stop), FindStopId(to_stop));
+    }
+
+    const domain::Stop& TransportCatalogue::GetStop(StopId stop_id) const {
+        return stops_.at(stop_id);
+    }
+
+    const domain::Bus& TransportCatalogue::GetBus(BusId bus_id) const {
+        return buses_.at(bus_id);
+    }
+
+    const std::vector<domain::StopId>& TransportCatalogue::GetRouteStops(BusId bus_id) const {
+        return buses_.at(bus_id).stops;
+    }
+
+    TransportCatalogue::BusIdRange TransportCatalogue::GetBusesAtStop(StopId stop_id) const {
+        if (!is_buses_at_stops_indexed_) {
+            throw std::logic_error("Buses at stops are not indexed");
+        }
+        return {buses_at_stops_.begin() + buses_at_stops_offsets_.at(stop_id),
+                buses_at_stops_.begin() + buses_at_stops_offsets_.at(stop_id + 1)};
+    }
+
+    int TransportCatalogue::GetDistance(StopId from_stop, StopId to_stop) const {
+        const RoadDistance* found_distance = FindRoadDistance(from_stop, to_stop);
+        if (!found_distance) {
+            throw std::out_of_range("No distance between stops");
         }
+        return found_distance->distance;
     }
 
-    const TransportCatalogue::RouteMap &TransportCatalogue::GetRoutes() const {
-        return routes_;
+    const TransportCatalogue::RoadDistance* TransportCatalogue::FindRoadDistance(StopId from_stop, StopId to_stop) const {
+        const RoadDistanceRange distances = GetRoadDistances(from_stop);
+        const auto found_distance = std::lower_bound(distances.begin(), distances.end(), to_stop,
+                                                     [](const RoadDistance& lhs, StopId rhs) {
+            return lhs.to < rhs;
+        });
+        return found_distance == distances.end() || found_distance->to != to_stop ? nullptr : &*found_distance;
     }
 
     const std::deque<domain::Stop> &TransportCatalogue::GetStops() const {
         return stops_;
     }
 
-    const TransportCatalogue::DistanceMap &TransportCatalogue::GetDistanceBetweenStops() const {
-        return distance_between_stops_;
+    const std::deque<domain::Bus> &TransportCatalogue::GetBuses() const {
+        return buses_;
+    }
+
+    TransportCatalogue::RouteStats TransportCatalogue::GetRouteStats(const Bus& bus) {
+        return {bus.stops_on_route, bus.unique_stops, bus.route_length, bus.curvature};
+    }
+
+    std::vector<domain::BusId> TransportCatalogue::GetBusIdsByName() const {
+        std::vector<BusId> result(buses_.size());
+        for (BusId bus_id = 0; bus_id < result.size(); ++bus_id) {
+            result[bus_id] = bus_id;
+        }
+        std::sort(result.begin(), result.end(), [this](BusId lhs, BusId rhs) {
+            return buses_[lhs].number < buses_[rhs].number;
+        });
+        return result;
+    }
+
+    TransportCatalogue::RoadDistanceRange TransportCatalogue::GetRoadDistances(StopId from_stop) const {
+        if (from_stop >= stops_.size()) {
+            throw std::out_of_range("Unknown stop");
+        }
+        return {road_distances_.begin() + road_distances_offsets_[from_stop],
+                road_distances_.begin() + road_distances_offsets_[from_stop + 1]};
+    }
+
+    std::vector<domain::StopId> TransportCatalogue::FindStopIds(const std::vector<std::string_view>& stop_names) const {
+        std::vector<StopId> result;
+        result.reserve(stop_names.size());
+        if (stop_hash_.IsEmpty()) {
+            for (const StopId* stop_id : stop_ids_.FindBatch(stop_names)) {
+                result.push_back(stop_id ? *stop_id : domain::NO_ID);
+            }
+        } else {
+            for (const std::string_view stop_name : stop_names) {
+                result.push_back(FindStopId(stop_name));
+            }
+        }
+        return result;
+    }
+
+    void TransportCatalogue::AddStops(const std::vector<StopInput>& stops) {
+        road_distances_offsets_.reserve(stops_.size() + stops.size() + 1);
+        for (const auto& [name, coordinates] : stops) {
+            AddStop(name, coordinates);
+        }
+    }
+
+    // Прежние и новые расстояния раскладываются по остановкам подсчётом, затем списки остановок сортируются
+    // и схлопываются независимо друг от друга и упаковываются в один массив. Параметры маршрутов тоже
+    // считаются независимо
+    void TransportCatalogue::AddDistancesAndBuses(BaseInput<StopId> base) {
+        const auto is_unknown = [this](StopId stop) {
+            return stop >= stops_.size();
+        };
+        for (const auto& distance : base.distances) {
+            if (is_unknown(distance.from_stop) || is_unknown(distance.to_stop)) {
+                throw std::out_of_range("Unknown stop in road distances");
+            }
+        }
+        for (const auto& bus : base.buses) {
+            if (std::any_of(bus.stops.begin(), bus.stops.end(), is_unknown)) {
+                throw std::out_of_range("Unknown stop in bus " + std::string(bus.number));
+            }
+        }
+
+        PackDistances(base.distances);
+
+        std::vector<BusId> computed_buses;
+        for (auto& bus : base.buses) {
+            Bus& added_bus = buses_[AppendBus(bus.number, std::move(bus.stops), bus.is_roundtrip)];
+            if (bus.stats) {
+                added_bus.stops_on_route = bus.stats->stops_on_route;
+                added_bus.unique_stops = bus.stats->unique_stops;
+                added_bus.route_length = bus.stats->route_length;
+                added_bus.curvature = bus.stats->curvature;
+            } else {
+                computed_buses.push_back(added_bus.id);
+            }
+        }
+        parallel::ParallelFor(computed_buses.size(), [this, &computed_buses](size_t index) {
+            ComputeRouteStats(buses_[computed_buses[index]]);
+        });
+
+        IndexBusesAtStops();
+    }
+
+    domain::BusId TransportCatalogue::AppendBus(std::string_view bus_number, std::vector<StopId> stops,
+                                                bool is_roundtrip) {
+        const auto bus_id = static_cast<BusId>(buses_.size());
+        Bus& bus = buses_.emplace_back();
+        bus.number = names_.Intern(bus_number);
+        bus.is_roundtrip = is_roundtrip;
+        bus.id = bus_id;
+        bus.stops = std::move(stops);
+        if (bus_hash_.IsEmpty()) {
+            bus_ids_.Add(bus.number, bus_id);
+        }
+        is_buses_at_stops_indexed_ = false;
+        return bus_id;
+    }
+
+    void TransportCatalogue::ComputeRouteStats(Bus& bus) const {
+        std::vector<StopId> unique_stops = bus.stops;
+        std::sort(unique_stops.begin(), unique_stops.end());
+        double geographic_distance = 0;
+        int route_length = 0;
+        const size_t route_size = bus.GetRouteSize();
+        for (size_t i = 1; i < route_size; ++i) {
+            const StopId from_stop = bus.GetRouteStop(i - 1);
+            const StopId to_stop = bus.GetRouteStop(i);
+            geographic_distance += ComputeDistance(stops_[from_stop].coordinates, stops_[to_stop].coordinates);
+            route_length += GetDistance(from_stop, to_stop);
+        }
+        bus.stops_on_route = static_cast<int>(route_size);
+        bus.unique_stops = static_cast<int>(std::unique(unique_stops.begin(), unique_stops.end()) - unique_stops.begin());
+        bus.route_length = route_length;
+        bus.curvature = route_length / geographic_distance;
+    }
+
+    void TransportCatalogue::PackDistances(const std::vector<BaseInput<StopId>::DistanceInput>& distances) {
+        const size_t stop_count = stops_.size();
+        std::vector<size_t> offsets(stop_count + 1, 0);
+        for (size_t stop = 0; stop < stop_count; ++stop) {
+            offsets[stop + 1] = road_distances_offsets_[stop + 1] - road_distances_offsets_[stop];
+        }
+        for (const auto& distance : distances) {
+            ++offsets[distance.from_stop + 1];
+            ++offsets[distance.to_stop + 1];
+        }
+        for (size_t stop = 1; stop < offsets.size(); ++stop) {
+            offsets[stop] += offsets[stop - 1];
+        }
+
+        // Прежние расстояния остановки идут перед новыми, новые - в порядке задания
+        std::vector<RoadDistance> unpacked(offsets.back());
+        std::vector<size_t> next_positions(offsets.begin(), offsets.end() - 1);
+        for (size_t stop = 0; stop < stop_count; ++stop) {
+            for (const RoadDistance& road_distance : GetRoadDistances(static_cast<StopId>(stop))) {
+                unpacked[next_positions[stop]++] = road_distance;
+            }
+        }
+        for (const auto& [from_stop, to_stop, distance] : distances) {
+            unpacked[next_positions[from_stop]++] = {to_stop, distance, true};
+            unpacked[next_positions[to_stop]++] = {from_stop, distance, false};
+        }
+
+        std::vector<size_t> collapsed_sizes(stop_count);
+        parallel::ParallelFor(stop_count, [&unpacked, &offsets, &collapsed_sizes](size_t stop) {
+            const auto begin = unpacked.begin() + offsets[stop];
+            collapsed_sizes[stop] = CollapseDistances(begin, unpacked.begin() + offsets[stop + 1]) - begin;
+        });
+
+        road_distances_.clear();
+        road_distances_.reserve(std::accumulate(collapsed_sizes.begin(), collapsed_sizes.end(), size_t{0}));
+        road_distances_offsets_.assign(1, 0);
+        for (size_t stop = 0; stop < stop_count; ++stop) {
+            const auto begin = unpacked.begin() + offsets[stop];
+            road_distances_.insert(road_distances_.end(), begin, begin + collapsed_sizes[stop]);
+            road_distances_offsets_.push_back(road_distances_.size());
+        }
+    }
+
+    void TransportCatalogue::SetDistance(StopId from_stop, StopId to_stop, int distance, bool is_explicit) {
+        const RoadDistanceRange distances = GetRoadDistances(from_stop);
+        const auto found_distance = std::lower_bound(distances.begin(), distances.end(), to_stop,
+                                                     [](const RoadDistance& lhs, StopId rhs) {
+            return lhs.to < rhs;
+        });
+        const auto position = road_distances_.begin() + (found_distance - road_distances_.cbegin());
+        if (found_distance == distances.end() || found_distance->to != to_stop) {
+            road_distances_.insert(position, {to_stop, distance, is_explicit});
+            for (size_t stop = from_stop + 1; stop < road_distances_offsets_.size(); ++stop) {
+                ++road_distances_offsets_[stop];
+            }
+        } else if (is_explicit || !found_distance->is_explicit) {
+            *position = {to_stop, distance, is_explicit};
+        }
     }
-}
\ No newline at end of file
+}
@@ -2,8 +2,7 @@
 
 #include <deque>
 #include <iostream>
-#include <map>
-#include <set>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -11,6 +10,9 @@
 
 #include "domain.h"
 #include "geo.h"
+#include "name_index.h"
+#include "perfect_hash.h"
+#include "ranges.h"
 
 namespace transport_catalogue {
 
@@ -19,31 +21,128 @@ namespace transport_catalogue {
     public:
         using Bus = domain::Bus;
         using Stop = domain::Stop;
-        using RouteMap = std::map<std::string_view, std::vector<std::string_view>>;
-        using DistanceMap = std::unordered_map<std::pair<Stop*, Stop*>, int, domain::PairPtrHash<Stop*, Stop*>>;
+        using StopId = domain::StopId;
+        using BusId = domain::BusId;
+        using BusIdRange = ranges::Range<std::vector<BusId>::const_iterator>;
+        // Расстояние по дорогам до соседней остановки. is_explicit == false, если расстояние взято
+        // из обратного направления, потому что прямое не задано
+        struct RoadDistance {
+            StopId to;
+            int distance;
+            bool is_explicit;
+        };
+        using RoadDistanceRange = ranges::Range<std::vector<RoadDistance>::const_iterator>;
+
+        struct StopInput {
+            std::string_view name;
+            geo::Coordinates coordinates;
+        };
+        struct RouteStats {
+            int stops_on_route = 0;
+            int unique_stops = 0;
+            int route_length = 0;
+            double curvature = 0.;
+        };
+        // Содержимое базы для загрузки одним вызовом AddBase. StopRef - способ ссылаться на остановки
+        // в расстояниях и маршрутах: названием (std::string_view) или номером (StopId).
+        // Строки не копируются до вызова AddBase и должны жить до его завершения
+        template <typename StopRef>
+        struct BaseInput {
+            struct DistanceInput {
+                StopRef from_stop;
+                StopRef to_stop;
+                int distance = 0;
+            };
+            struct BusInput {
+                std::string_view number;
+                // Остановки в порядке следования, для некольцевого маршрута - только в прямом направлении
+                std::vector<StopRef> stops;
+                bool is_roundtrip = false;
+                // Параметры маршрута, если они уже посчитаны (например, сохранены в базе): AddBase их не пересчитывает
+                std::optional<RouteStats> stats;
+            };
+
+            std::vector<StopInput> stops;
+            std::vector<DistanceInput> distances;
+            std::vector<BusInput> buses;
+        };
 
         TransportCatalogue() noexcept = default;
 
+        // Бросают std::out_of_range, если маршрут проходит через неизвестную остановку
         void AddRoute(std::string_view bus_number, const std::vector<std::string>& stops, bool is_roundtrip);
-        void AddStop(std::string_view stop_name, const geo::Coordinates& coordinates);
+        BusId AddRoute(std::string_view bus_number, std::vector<StopId> stops, bool is_roundtrip);
+        StopId AddStop(std::string_view stop_name, const geo::Coordinates& coordinates);
         void AddDistanceBetweenStops(std::string_view from_stop_name, std::string_view to_stop_name, double distance);
+        void AddDistanceBetweenStops(StopId from_stop, StopId to_stop, int distance);
+        // Добавляет остановки, затем расстояния, затем маршруты и строит списки автобусов остановок.
+        // Названия остановок разрешаются в номера одним проходом, параметры маршрутов без заданных stats
+        // считаются в нескольких потоках.
+        // Бросает std::out_of_range, если расстояние или маршрут ссылаются на неизвестную остановку
+        void AddBase(const BaseInput<std::string_view>& base);
+        void AddBase(BaseInput<StopId> base);
+        // Переключает поиск по названиям на минимальные совершенные хэши, сохранённые в базе вместе со справочником.
+        // Вызывается до добавления остановок и автобусов: хэш-таблицы названий тогда не строятся
+        void SetNameHashes(domain::PerfectHash stop_hash, domain::PerfectHash bus_hash);
+        // Строит списки автобусов, проходящих через каждую остановку. Вызывается после добавления всех маршрутов,
+        // до этого FindBusesAtStops и GetBusesAtStop бросают std::logic_error
+        void IndexBusesAtStops();
 
-        Bus* FindRoute(std::string_view bus_name) const;
-        Stop* FindStop(std::string_view stop_name) const;
-        const std::set<std::string_view>& FindBusesAtStops(std::string_view stop_name) const;
+        const Bus* FindRoute(std::string_view bus_name) const;
+        const Stop* FindStop(std::string_view stop_name) const;
+        // Номер остановки или автобуса по названию. NO_ID, если такого нет
+        [[nodiscard]] StopId FindStopId(std::string_view stop_name) const;
+        [[nodiscard]] BusId FindBusId(std::string_view bus_name) const;
+        // Автобусы, проходящие через остановку, по возрастанию названий
+        [[nodiscard]] BusIdRange FindBusesAtStops(std::string_view stop_name) const;
         int FindDistanceBetweenStops(std::string_view from_stop, std::string_view to_stop) const;
 
-        const RouteMap& GetRoutes() const;
+        const Stop& GetStop(StopId stop_id) const;
+        const Bus& GetBus(BusId bus_id) const;
+        // Хранимые остановки маршрута: у некольцевого - только в прямом направлении
+        const std::vector<StopId>& GetRouteStops(BusId bus_id) const;
+        [[nodiscard]] BusIdRange GetBusesAtStop(StopId stop_id) const;
+        // Расстояние по дорогам между соседними остановками. Если задано только обратное - берётся оно
+        [[nodiscard]] int GetDistance(StopId from_stop, StopId to_stop) const;
+        // Запись о расстоянии до соседней остановки. nullptr, если расстояние не задано ни в одну сторону
+        [[nodiscard]] const RoadDistance* FindRoadDistance(StopId from_stop, StopId to_stop) const;
+        // Расстояния от остановки до соседних по возрастанию номера соседа
+        [[nodiscard]] RoadDistanceRange GetRoadDistances(StopId from_stop) const;
+
         const std::deque<Stop>& GetStops() const;
-        const DistanceMap& GetDistanceBetweenStops() const;
+        const std::deque<Bus>& GetBuses() const;
+        // Параметры маршрута автобуса в виде, в котором их принимает AddBase
+        [[nodiscard]] static RouteStats GetRouteStats(const Bus& bus);
+        // Номера автобусов в порядке возрастания их названий
+        [[nodiscard]] std::vector<BusId> GetBusIdsByName() const;
 
     private:
+        // Номера остановок по названиям, NO_ID для неизвестных
+        [[nodiscard]] std::vector<StopId> FindStopIds(const std::vector<std::string_view>& stop_names) const;
+        void AddStops(const std::vector<StopInput>& stops);
+        void AddDistancesAndBuses(BaseInput<StopId> base);
+        // Добавляет расстояния к прежним и упаковывает все расстояния в road_distances_
+        void PackDistances(const std::vector<BaseInput<StopId>::DistanceInput>& distances);
+        BusId AppendBus(std::string_view bus_number, std::vector<StopId> stops, bool is_roundtrip);
+        void ComputeRouteStats(Bus& bus) const;
+        void SetDistance(StopId from_stop, StopId to_stop, int distance, bool is_explicit);
+
+        domain::StringArena names_;
         std::deque<Bus> buses_;
         std::deque<Stop> stops_;
-        std::unordered_map<std::string_view, Bus*> pointer_to_buses_;
-        std::unordered_map<std::string_view, Stop*> pointer_to_stops_;
-        std::unordered_map<Stop*, std::set<std::string_view>> buses_at_stops_;
-        DistanceMap distance_between_stops_;
-        RouteMap routes_;
+        domain::NameIndex<BusId> bus_ids_;
+        domain::NameIndex<StopId> stop_ids_;
+        domain::PerfectHash bus_hash_;
+        domain::PerfectHash stop_hash_;
+        // Автобусы остановки stop_id лежат в buses_at_stops_ в диапазоне
+        // [buses_at_stops_offsets_[stop_id], buses_at_stops_offsets_[stop_id + 1])
+        std::vector<BusId> buses_at_stops_;
+        std::vector<size_t> buses_at_stops_offsets_;
+        bool is_buses_at_stops_indexed_ = true;
+        // Расстояния от остановки stop_id лежат в road_distances_ в диапазоне
+        // [road_distances_offsets_[stop_id], road_distances_offsets_[stop_id + 1]).
+        // Массив упаковывается заново при каждом AddBase, одиночные расстояния вставляются в него сдвигом
+        std::vector<RoadDistance> road_distances_;
+        std::vector<size_t> road_distances_offsets_;
     };
-}
\ No newline at end of file
+}
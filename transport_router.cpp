@@ -1,10 +1,83 @@
+#include <algorithm>
+#include <cstdint>
 #include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
 
+#include "parallel.h"
 #include "transport_router.h"
 
 namespace transport_catalogue::router {
+    using namespace std::literals;
+
     namespace {
         const TransportCatalogue FAKE_CATALOGUE;
+
+        const uint32_t HILBERT_ORDER = 16;
+        const uint32_t HILBERT_SIDE = 1u << HILBERT_ORDER;
+
+        // Номер клетки (x, y) решётки HILBERT_SIDE x HILBERT_SIDE вдоль кривой Гильберта
+        uint64_t ComputeHilbertIndex(uint32_t x, uint32_t y) {
+            uint64_t index = 0;
+            for (uint32_t side = HILBERT_SIDE / 2; side > 0; side /= 2) {
+                const uint32_t rx = (x & side) > 0;
+                const uint32_t ry = (y & side) > 0;
+                index += static_cast<uint64_t>(side) * side * ((3 * rx) ^ ry);
+                if (ry == 0) {
+                    if (rx == 1) {
+                        x = side - 1 - x;
+                        y = side - 1 - y;
+                    }
+                    std::swap(x, y);
+                }
+            }
+            return index;
+        }
+
+        uint32_t ToHilbertCell(double value, double min_value, double max_value) {
+            if (max_value - min_value < std::numeric_limits<double>::epsilon()) {
+                return 0;
+            }
+            const double cell = (value - min_value) / (max_value - min_value) * (HILBERT_SIDE - 1);
+            return static_cast<uint32_t>(cell);
+        }
+
+        // Остановки в порядке обхода кривой Гильберта по их координатам:
+        // близкие остановки получают близкие номера вершин графа
+        std::vector<const domain::Stop*> SortStopsByHilbertCurve(const std::deque<domain::Stop>& stops) {
+            std::vector<const domain::Stop*> result;
+            result.reserve(stops.size());
+            if (stops.empty()) {
+                return result;
+            }
+
+            auto [min_lat, max_lat] = std::pair{stops.front().coordinates.lat, stops.front().coordinates.lat};
+            auto [min_lng, max_lng] = std::pair{stops.front().coordinates.lng, stops.front().coordinates.lng};
+            for (const auto& stop : stops) {
+                min_lat = std::min(min_lat, stop.coordinates.lat);
+                max_lat = std::max(max_lat, stop.coordinates.lat);
+                min_lng = std::min(min_lng, stop.coordinates.lng);
+                max_lng = std::max(max_lng, stop.coordinates.lng);
+            }
+
+            std::vector<std::pair<uint64_t, const domain::Stop*>> indexed_stops;
+            indexed_stops.reserve(stops.size());
+            for (const auto& stop : stops) {
+                const uint32_t x = ToHilbertCell(stop.coordinates.lng, min_lng, max_lng);
+                const uint32_t y = ToHilbertCell(stop.coordinates.lat, min_lat, max_lat);
+                indexed_stops.emplace_back(ComputeHilbertIndex(x, y), &stop);
+            }
+            std::stable_sort(indexed_stops.begin(), indexed_stops.end(), [](const auto& lhs, const auto& rhs) {
+                return lhs.first < rhs.first;
+            });
+
+            for (const auto& [index, stop] : indexed_stops) {
+                result.push_back(stop);
+            }
+            return result;
+        }
     }
 
     CustomWeight operator+(const CustomWeight& lhs, const CustomWeight& rhs) {
@@ -29,58 +102,205 @@ namespace transport_catalogue::router {
         return hash_id + hash_span * prime_ + hash_time * (prime_ * prime_);
     }
 
-    Item::Item(ItemType type, int span_count, std::string_view name)
-        : type(type)
-        , span_count(span_count)
-        , name(name) {
+    Item::Item(ItemType type, int span_count, uint32_t name_id)
+        : name_id(name_id)
+        , span_count(static_cast<uint16_t>(span_count))
+        , type(type) {
     }
 
-    TransportRouter::TransportRouter(size_t vertex_count)
-        : graph_(vertex_count)
+    TransportRouter::TransportRouter(Graph graph)
+        : graph_(std::move(graph))
         , catalogue_(FAKE_CATALOGUE) {
     }
 
-    TransportRouter::TransportRouter(const TransportCatalogue& catalogue)
-        : graph_(catalogue.GetStops().size() * 2)
-        , catalogue_(catalogue) {
+    TransportRouter::TransportRouter(const TransportCatalogue& catalogue, GraphModel graph_model)
+        : graph_builder_(catalogue.GetStops().size() * (graph_model == GraphModel::COMPLETE ? 2 : 1))
+        , graph_(graph_builder_.GetVertexCount())
+        , catalogue_(catalogue)
+        , graph_model_(graph_model) {
     }
 
-    void TransportRouter::AddStops(Minutes bus_wait_time) {
+    void TransportRouter::AddStops(Minutes bus_wait_time, VertexOrder vertex_order) {
         const auto& stops = catalogue_.GetStops();
+        std::vector<const domain::Stop*> ordered_stops;
+        if (vertex_order == VertexOrder::HILBERT) {
+            ordered_stops = SortStopsByHilbertCurve(stops);
+        } else {
+            ordered_stops.reserve(stops.size());
+            for (const auto& stop : stops) {
+                ordered_stops.push_back(&stop);
+            }
+        }
+
+        bus_wait_time_ = bus_wait_time;
+        std::vector<domain::StopId> stop_ids;
+        stop_ids.reserve(stops.size());
         for (const auto& stop : stops) {
-            trip_indexes_.emplace(stop.name, stop_indexes_.size());
-            stop_indexes_.push_back(stop.name);
-            wait_indexes_.emplace(stop.name, stop_indexes_.size());
-            stop_indexes_.push_back(stop.name);
-            items_.emplace_back(ItemType::WAIT, 0, stop.name);
-            graph_.AddEdge({wait_indexes_[stop.name], trip_indexes_[stop.name], bus_wait_time});
+            stop_names_.push_back(stop.name);
+            stop_ids.push_back(stop.id);
+        }
+        stop_hash_ = domain::PerfectHash(stop_names_, stop_ids);
+        trip_vertexes_.resize(stops.size());
+        wait_vertexes_.resize(stops.size());
+
+        if (graph_model_ == GraphModel::LINEAR) {
+            // Ожидание автобуса учитывается на рёбрах посадки, которые добавляет AddRoutes
+            for (const domain::Stop* stop : ordered_stops) {
+                wait_vertexes_[stop->id] = stop_indexes_.size();
+                stop_indexes_.push_back(stop->name);
+            }
+            return;
+        }
+
+        for (const domain::Stop* stop : ordered_stops) {
+            trip_vertexes_[stop->id] = stop_indexes_.size();
+            stop_indexes_.push_back(stop->name);
+            wait_vertexes_[stop->id] = stop_indexes_.size();
+            stop_indexes_.push_back(stop->name);
+            items_.emplace_back(ItemType::WAIT, 0, stop->id);
+            graph_builder_.AddEdge({wait_vertexes_[stop->id], trip_vertexes_[stop->id], bus_wait_time});
         }
     }
 
 
     void TransportRouter::AddRoutes(MetersPerMinutes bus_velocity) {
-        const auto& routes = catalogue_.GetRoutes();
-        for (const auto& [bus_name, route] : routes) {
-            const size_t end_stop_index = route.size() / 2;
-            if(catalogue_.FindRoute(bus_name)->is_roundtrip) {
-                AddRouteOuterLoop(bus_name, route.cbegin(), route.cend(), bus_velocity);
+        AddRouteEdges(bus_velocity, {});
+    }
+
+    void TransportRouter::AddRoutes(MetersPerMinutes bus_velocity, const TransportRouter& previous,
+                                    const std::unordered_set<std::string_view>& changed_stops) {
+        if (graph_model_ != GraphModel::COMPLETE || previous.graph_model_ != GraphModel::COMPLETE) {
+            AddRouteEdges(bus_velocity, {});
+            return;
+        }
+
+        // Вершины прежнего графа в новом. В полной модели вершина посадки остановки предшествует вершине ожидания
+        std::vector<graph::VertexId> vertexes(previous.graph_.GetVertexCount());
+        for (size_t stop = 0; stop < previous.stop_names_.size(); ++stop) {
+            const domain::StopId stop_id = catalogue_.FindStopId(previous.stop_names_[stop]);
+            if (stop_id != domain::NO_ID) {
+                const graph::VertexId wait_vertex = previous.wait_vertexes_[stop];
+                vertexes[wait_vertex] = wait_vertexes_[stop_id];
+                vertexes[wait_vertex - 1] = trip_vertexes_[stop_id];
+            }
+        }
+
+        // Номера автобусов в новом справочнике по прежним номерам, NO_ID - рёбра автобуса строятся заново
+        std::vector<std::optional<RouteEdges>> reused_edges(catalogue_.GetBuses().size());
+        std::vector<domain::BusId> bus_ids(previous.bus_names_.size(), domain::NO_ID);
+        for (size_t previous_id = 0; previous_id < previous.bus_names_.size(); ++previous_id) {
+            const domain::BusId bus_id = catalogue_.FindBusId(previous.bus_names_[previous_id]);
+            if (bus_id == domain::NO_ID) {
+                continue;
+            }
+            const auto& stops = catalogue_.GetBus(bus_id).stops;
+            if (std::none_of(stops.begin(), stops.end(), [&](domain::StopId stop) {
+                    return changed_stops.count(catalogue_.GetStop(stop).name) > 0;
+                })) {
+                bus_ids[previous_id] = bus_id;
+                reused_edges[bus_id].emplace();
+            }
+        }
+
+        // Доминируемые рёбра таких автобусов в прежнем графе проигрывали рёбрам автобусов, которые тоже не изменились,
+        // и в новом графе проиграют им же, поэтому достаточно рёбер, оставшихся после заморозки
+        std::vector<size_t> edge_counts(catalogue_.GetBuses().size());
+        for (const Item& item : previous.items_) {
+            if (item.type == ItemType::BUS && bus_ids[item.name_id] != domain::NO_ID) {
+                ++edge_counts[bus_ids[item.name_id]];
+            }
+        }
+        for (domain::BusId bus_id = 0; bus_id < edge_counts.size(); ++bus_id) {
+            if (reused_edges[bus_id]) {
+                reused_edges[bus_id]->edges.reserve(edge_counts[bus_id]);
+                reused_edges[bus_id]->items.reserve(edge_counts[bus_id]);
+            }
+        }
+        for (graph::EdgeId edge_id = 0; edge_id < previous.graph_.GetEdgeCount(); ++edge_id) {
+            const Item& item = previous.items_[edge_id];
+            if (item.type != ItemType::BUS || bus_ids[item.name_id] == domain::NO_ID) {
+                continue;
+            }
+            const auto& edge = previous.graph_.GetEdge(edge_id);
+            RouteEdges& route_edges = *reused_edges[bus_ids[item.name_id]];
+            route_edges.edges.push_back({vertexes[edge.from], vertexes[edge.to], edge.weight});
+            route_edges.items.emplace_back(ItemType::BUS, item.span_count, bus_ids[item.name_id]);
+        }
+        AddRouteEdges(bus_velocity, std::move(reused_edges));
+    }
+
+    void TransportRouter::AddRouteEdges(MetersPerMinutes bus_velocity,
+                                        std::vector<std::optional<RouteEdges>> reused_edges) {
+        for (const auto& bus : catalogue_.GetBuses()) {
+            bus_names_.push_back(bus.number);
+        }
+
+        // Автобусы обходятся в порядке названий: от порядка рёбер зависит выбор среди равных по времени маршрутов
+        std::vector<const domain::Bus*> buses;
+        std::vector<graph::VertexId> first_ride_vertexes;
+        graph::VertexId next_ride_vertex = graph_builder_.GetVertexCount();
+        for (const domain::BusId bus_id : catalogue_.GetBusIdsByName()) {
+            const domain::Bus& bus = catalogue_.GetBus(bus_id);
+            if (bus.stops.empty()) {
+                continue;
+            }
+            if (bus.stops.size() > std::numeric_limits<uint16_t>::max()) {
+                throw std::length_error("Too many stops on route of bus "s + std::string{bus.number});
+            }
+            buses.push_back(&bus);
+            first_ride_vertexes.push_back(next_ride_vertex);
+            if (graph_model_ == GraphModel::LINEAR) {
+                next_ride_vertex += CountRideVertexes(bus);
+            }
+        }
+
+        std::vector<RouteEdges> route_edges(buses.size());
+        parallel::ParallelFor(buses.size(), [&](size_t index) {
+            const domain::BusId bus_id = buses[index]->id;
+            if (bus_id < reused_edges.size() && reused_edges[bus_id]) {
+                route_edges[index] = std::move(*reused_edges[bus_id]);
             } else {
-                AddRouteOuterLoop(bus_name, route.cbegin(), route.cbegin() + end_stop_index + 1, bus_velocity);
-                AddRouteOuterLoop(bus_name, route.cbegin() + end_stop_index, route.cend(), bus_velocity);
+                route_edges[index] = BuildRouteEdges(*buses[index], bus_velocity, first_ride_vertexes[index]);
+            }
+        });
+
+        // Склеиваем результаты в порядке автобусов, поэтому номера вершин и рёбер не зависят от числа потоков
+        for (auto& [edges, items, ride_stops] : route_edges) {
+            for (const domain::StopId stop : ride_stops) {
+                graph_builder_.AddVertex();
+                stop_indexes_.push_back(stop_names_[stop]);
+            }
+            for (const auto& edge : edges) {
+                graph_builder_.AddEdge(edge);
             }
+            items_.insert(items_.end(), items.begin(), items.end());
+            edges = {};
         }
+        Freeze();
     }
 
     const TransportRouter::Graph& TransportRouter::GetGraph() const {
         return graph_;
     }
 
-    const TransportRouter::IndexMap& TransportRouter::GetTripIndexes() const {
-        return trip_indexes_;
+    GraphModel TransportRouter::GetGraphModel() const {
+        return graph_model_;
+    }
+
+    std::optional<graph::VertexId> TransportRouter::FindWaitVertex(std::string_view stop_name) const {
+        const domain::StopId stop_id = stop_hash_.Find(stop_name);
+        if (stop_id >= stop_names_.size() || stop_id >= wait_vertexes_.size() || stop_names_[stop_id] != stop_name) {
+            return std::nullopt;
+        }
+        return wait_vertexes_[stop_id];
     }
 
-    const TransportRouter::IndexMap& TransportRouter::GetWaitIndexes() const {
-        return wait_indexes_;
+    const std::vector<graph::VertexId>& TransportRouter::GetWaitVertexes() const {
+        return wait_vertexes_;
+    }
+
+    const domain::PerfectHash& TransportRouter::GetStopHash() const {
+        return stop_hash_;
     }
 
     const std::vector<std::string_view>& TransportRouter::GetStopIndexes() const {
@@ -91,35 +311,145 @@ namespace transport_catalogue::router {
         return items_;
     }
 
-    void TransportRouter::AddWaitIndex(std::string_view name, graph::VertexId id) {
-         wait_indexes_.emplace(name, id);
+    const std::vector<std::string_view>& TransportRouter::GetStopNames() const {
+        return stop_names_;
+    }
+
+    const std::vector<std::string_view>& TransportRouter::GetBusNames() const {
+        return bus_names_;
+    }
+
+    std::string_view TransportRouter::GetItemName(const Item& item) const {
+        return item.type == ItemType::BUS ? bus_names_[item.name_id] : stop_names_[item.name_id];
+    }
+
+    void TransportRouter::AddWaitVertex(graph::VertexId vertex) {
+        wait_vertexes_.push_back(vertex);
+    }
+
+    void TransportRouter::SetStopHash(domain::PerfectHash stop_hash) {
+        stop_hash_ = std::move(stop_hash);
     }
 
     void TransportRouter::AddItem(const Item& item) {
         items_.push_back(item);
     }
 
-    graph::EdgeId TransportRouter::AddEdge(const graph::Edge<Minutes>& edge) {
-        return graph_.AddEdge(edge);
+    void TransportRouter::AddStopName(std::string_view name) {
+        stop_names_.push_back(name);
+    }
+
+    void TransportRouter::AddBusName(std::string_view name) {
+        bus_names_.push_back(name);
     }
 
-    void TransportRouter::AddRouteOuterLoop(std::string_view bus_name, RundomIt begin, RundomIt end, MetersPerMinutes bus_velocity) {
-        for (auto it = begin; it != (end - 1); ++it) {
-            RouteInfo route_info {bus_name, *it, *it, 0., 0};
-            AddRouteInnerLoop(route_info, it + 1, end, bus_velocity);
+    // Параллельные рёбра между одной парой вершин (например, автобусы на общем участке) кроме самого быстрого
+    // никогда не попадут в кратчайший путь. Оставляем только его, вместе с его элементом ответа
+    void TransportRouter::Freeze() {
+        const std::vector<graph::EdgeId> dominant_edges = graph::FindDominantEdges(graph_builder_);
+        std::vector<graph::Edge<Minutes>> edges;
+        std::vector<Item> items;
+        edges.reserve(dominant_edges.size());
+        items.reserve(dominant_edges.size());
+        for (const graph::EdgeId edge_id : dominant_edges) {
+            edges.push_back(graph_builder_.GetEdge(edge_id));
+            items.push_back(items_[edge_id]);
+        }
+
+        graph_ = Graph(graph_builder_.GetVertexCount(), std::move(edges));
+        items_ = std::move(items);
+        graph_builder_ = GraphBuilder{};
+        trip_vertexes_ = {};
+    }
+
+    TransportRouter::RouteEdges TransportRouter::BuildRouteEdges(const domain::Bus& bus, MetersPerMinutes bus_velocity,
+                                                                 graph::VertexId first_ride_vertex) const {
+        RouteEdges result;
+        const auto add_run = [&](auto begin, auto end) {
+            if (graph_model_ == GraphModel::LINEAR) {
+                AddRunLinear(result, bus.id, begin, end, bus_velocity, first_ride_vertex);
+            } else {
+                AddRunComplete(result, bus.id, begin, end, bus_velocity);
+            }
+        };
+
+        const auto& route = bus.stops;
+        add_run(route.cbegin(), route.cend());
+        if (!bus.is_roundtrip) {
+            add_run(route.crbegin(), route.crend());
+        }
+        return result;
+    }
+
+    // Ребро от каждой остановки рейса до каждой следующей
+    template <typename RundomIt>
+    void TransportRouter::AddRunComplete(RouteEdges& route_edges, domain::BusId bus_id, RundomIt begin, RundomIt end,
+                                         MetersPerMinutes bus_velocity) const {
+        const size_t stop_count = end - begin;
+        const std::vector<Minutes> span_times = ComputeSpanTimes(begin, end, bus_velocity);
+        std::vector<graph::VertexId> trip_vertexes;
+        std::vector<graph::VertexId> wait_vertexes;
+        trip_vertexes.reserve(stop_count);
+        wait_vertexes.reserve(stop_count);
+        for (auto it = begin; it != end; ++it) {
+            trip_vertexes.push_back(trip_vertexes_[*it]);
+            wait_vertexes.push_back(wait_vertexes_[*it]);
+        }
+
+        route_edges.edges.reserve(route_edges.edges.size() + stop_count * (stop_count - 1) / 2);
+        route_edges.items.reserve(route_edges.items.size() + stop_count * (stop_count - 1) / 2);
+        for (size_t from = 0; from + 1 < stop_count; ++from) {
+            Minutes travel_time = 0.;
+            for (size_t to = from + 1; to < stop_count; ++to) {
+                travel_time += span_times[to - 1];
+                route_edges.items.emplace_back(ItemType::BUS, to - from, bus_id);
+                route_edges.edges.push_back({trip_vertexes[from], wait_vertexes[to], travel_time});
+            }
         }
     }
 
-    void TransportRouter::AddRouteInnerLoop(RouteInfo& route_info, RundomIt begin, RundomIt end, MetersPerMinutes bus_velocity) {
+    // Каждой остановке рейса соответствует своя вершина. Посадка - ребро от остановки с временем ожидания,
+    // поездка - ребро до следующей позиции рейса, выход - ребро нулевого веса обратно в вершину остановки
+    template <typename RundomIt>
+    void TransportRouter::AddRunLinear(RouteEdges& route_edges, domain::BusId bus_id, RundomIt begin, RundomIt end,
+                                       MetersPerMinutes bus_velocity, graph::VertexId first_ride_vertex) const {
+        const std::vector<Minutes> span_times = ComputeSpanTimes(begin, end, bus_velocity);
         for (auto it = begin; it != end; ++it) {
-            std::string_view to_stop = *it;
-            std::pair from_to_stops {trip_indexes_[route_info.from_stop], wait_indexes_[to_stop]};
-            double distance = catalogue_.FindDistanceBetweenStops(route_info.prev_stop, to_stop);
-            route_info.travel_time += (distance / bus_velocity);
-            ++route_info.span_count;
-            items_.emplace_back(ItemType::BUS, route_info.span_count, route_info.bus_name);
-            graph_.AddEdge({trip_indexes_[route_info.from_stop], wait_indexes_[to_stop], route_info.travel_time});
-            route_info.prev_stop = to_stop;
+            const graph::VertexId ride = first_ride_vertex + route_edges.ride_stops.size();
+            const graph::VertexId stop = wait_vertexes_[*it];
+            const domain::StopId stop_id = *it;
+            route_edges.ride_stops.push_back(stop_id);
+            if (it != begin) {
+                route_edges.items.emplace_back(ItemType::BUS, 1, bus_id);
+                route_edges.edges.push_back({ride - 1, ride, span_times[it - begin - 1]});
+                route_edges.items.emplace_back(ItemType::ALIGHT, 0, stop_id);
+                route_edges.edges.push_back({ride, stop, 0.});
+            }
+            if (it + 1 != end) {
+                route_edges.items.emplace_back(ItemType::WAIT, 0, stop_id);
+                route_edges.edges.push_back({stop, ride, bus_wait_time_});
+            }
         }
     }
+
+    // Время в пути между соседними остановками рейса
+    template <typename RundomIt>
+    std::vector<Minutes> TransportRouter::ComputeSpanTimes(RundomIt begin, RundomIt end,
+                                                           MetersPerMinutes bus_velocity) const {
+        std::vector<Minutes> result;
+        if (begin == end) {
+            return result;
+        }
+        result.reserve(end - begin - 1);
+        for (auto it = begin + 1; it != end; ++it) {
+            const double distance = catalogue_.GetDistance(*(it - 1), *it);
+            result.push_back(distance / bus_velocity);
+        }
+        return result;
+    }
+
+    size_t TransportRouter::CountRideVertexes(const domain::Bus& bus) const {
+        // Рейсы некольцевого маршрута делят конечную остановку, у каждого своя вершина на ней
+        return bus.is_roundtrip ? bus.stops.size() : bus.stops.size() * 2;
+    }
 }
\ No newline at end of file
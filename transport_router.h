@@ -1,6 +1,13 @@
 #pragma once
 
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
 #include "graph.h"
+#include "perfect_hash.h"
 #include "router.h"
 #include "transport_catalogue.h"
 
@@ -8,9 +15,22 @@ namespace transport_catalogue::router {
     using Minutes = double;
     using MetersPerMinutes = double;
 
-    enum class ItemType {
+    enum class ItemType : uint8_t {
         WAIT,
-        BUS
+        BUS,
+        ALIGHT  // выход из автобуса в линейной модели графа, в ответ не попадает
+    };
+
+    // Модель графа маршрутизации
+    enum class GraphModel {
+        COMPLETE,  // по две вершины на остановку, ребро от каждой остановки маршрута до каждой следующей
+        LINEAR     // вершина на остановку и на каждую позицию автобуса на маршруте, рёбра только между соседними
+    };
+
+    // Порядок нумерации вершин графа
+    enum class VertexOrder {
+        CATALOGUE,  // в порядке добавления остановок в справочник
+        HILBERT     // вдоль кривой Гильберта по координатам остановок
     };
 
     struct CustomWeight {
@@ -33,54 +53,93 @@ namespace transport_catalogue::router {
         static const std::size_t prime_ = 37;
     };
 
+    // Описание ребра графа для ответа на запрос Route. Название берётся из таблицы названий остановок
+    // (WAIT, ALIGHT) или автобусов (BUS) маршрутизатора по name_id
     struct Item {
-        Item(ItemType type, int span_count, std::string_view name);
+        Item(ItemType type, int span_count, uint32_t name_id);
 
+        uint32_t name_id;
+        uint16_t span_count;
         ItemType type;
-        int32_t span_count;
-        std::string_view name;
     };
+    static_assert(sizeof(Item) == 8);
 
     CustomWeight operator+(const CustomWeight& lhs, const CustomWeight& rhs);
 
     class TransportRouter {
     public:
-        using Graph = graph::DirectedWeightedGraph<Minutes>;
-        using IndexMap = std::unordered_map<std::string_view , graph::VertexId>;
-
-        explicit TransportRouter(size_t vertex_count);
-        explicit TransportRouter(const TransportCatalogue& catalogue);
-        void AddStops(Minutes bus_wait_time);
+        using Graph = graph::FrozenGraph<Minutes>;
+        using GraphBuilder = graph::DirectedWeightedGraph<Minutes>;
+
+        explicit TransportRouter(Graph graph);
+        explicit TransportRouter(const TransportCatalogue& catalogue, GraphModel graph_model = GraphModel::COMPLETE);
+        void AddStops(Minutes bus_wait_time, VertexOrder vertex_order = VertexOrder::CATALOGUE);
+        // Добавляет рёбра маршрутов и замораживает граф: после вызова GetGraph возвращает граф в формате CSR
+        // без доминируемых параллельных рёбер
         void AddRoutes(MetersPerMinutes bus_velocity);
+        // То же, но рёбра автобусов, не проходящих ни через одну из changed_stops, берутся из previous - графа
+        // прежней версии справочника в полной модели с той же скоростью, - а не строятся заново. changed_stops должны
+        // включать прежние и новые остановки всех автобусов, у которых изменились остановки или расстояния,
+        // тогда граф совпадает с построенным AddRoutes. В линейной модели граф строится заново целиком
+        void AddRoutes(MetersPerMinutes bus_velocity, const TransportRouter& previous,
+                       const std::unordered_set<std::string_view>& changed_stops);
 
         const Graph& GetGraph() const;
-        const IndexMap& GetTripIndexes() const;
-        const IndexMap& GetWaitIndexes() const;
+        [[nodiscard]] GraphModel GetGraphModel() const;
+        // Вершина ожидания остановки с названием stop_name. nullopt, если такой остановки нет
+        [[nodiscard]] std::optional<graph::VertexId> FindWaitVertex(std::string_view stop_name) const;
+        // Вершины ожидания остановок в порядке GetStopNames
+        const std::vector<graph::VertexId>& GetWaitVertexes() const;
+        const domain::PerfectHash& GetStopHash() const;
         const std::vector<std::string_view>& GetStopIndexes() const;
         const std::vector<Item>& GetItems() const;
+        const std::vector<std::string_view>& GetStopNames() const;
+        const std::vector<std::string_view>& GetBusNames() const;
+        [[nodiscard]] std::string_view GetItemName(const Item& item) const;
 
-        void AddWaitIndex(std::string_view name, graph::VertexId id);
+        void AddWaitVertex(graph::VertexId vertex);
+        void SetStopHash(domain::PerfectHash stop_hash);
         void AddItem(const Item& info);
-        graph::EdgeId AddEdge(const graph::Edge<Minutes>& edge);
+        void AddStopName(std::string_view name);
+        void AddBusName(std::string_view name);
 
     private:
-        struct RouteInfo {
-            const std::string_view bus_name;
-            const std::string_view from_stop;
-            std::string_view prev_stop;
-            Minutes travel_time = 0.;
-            int span_count = 0;
+        // Рёбра и элементы ответа одного автобуса. Строятся независимо от других автобусов
+        struct RouteEdges {
+            std::vector<graph::Edge<Minutes>> edges;
+            std::vector<Item> items;
+            // Остановки вершин рейса в линейной модели графа, в порядке номеров вершин
+            std::vector<domain::StopId> ride_stops;
         };
 
-        using RundomIt = std::vector<std::string_view>::const_iterator;
-        void AddRouteOuterLoop(std::string_view bus_name, RundomIt begin, RundomIt end, double bus_velocity);
-        void AddRouteInnerLoop(RouteInfo& route_info, RundomIt begin, RundomIt end, double bus_velocity);
-
+        // Строит рёбра автобусов, для которых нет готовых reused_edges[bus_id], и замораживает граф
+        void AddRouteEdges(MetersPerMinutes bus_velocity, std::vector<std::optional<RouteEdges>> reused_edges);
+        void Freeze();
+        RouteEdges BuildRouteEdges(const domain::Bus& bus, MetersPerMinutes bus_velocity,
+                                   graph::VertexId first_ride_vertex) const;
+        // Рейс - остановки [begin, end): обратный рейс некольцевого маршрута проходится обратными итераторами
+        template <typename RundomIt>
+        void AddRunComplete(RouteEdges& route_edges, domain::BusId bus_id, RundomIt begin, RundomIt end,
+                            MetersPerMinutes bus_velocity) const;
+        template <typename RundomIt>
+        void AddRunLinear(RouteEdges& route_edges, domain::BusId bus_id, RundomIt begin, RundomIt end,
+                          MetersPerMinutes bus_velocity, graph::VertexId first_ride_vertex) const;
+        template <typename RundomIt>
+        std::vector<Minutes> ComputeSpanTimes(RundomIt begin, RundomIt end, MetersPerMinutes bus_velocity) const;
+        size_t CountRideVertexes(const domain::Bus& bus) const;
+
+        GraphBuilder graph_builder_;
         Graph graph_;
-        IndexMap trip_indexes_;
-        IndexMap wait_indexes_;
         std::vector<std::string_view> stop_indexes_;
         std::vector<Item> items_;
+        // Вершины посадки остановок по номеру остановки в справочнике. Нужны только при построении графа
+        std::vector<graph::VertexId> trip_vertexes_;
+        std::vector<graph::VertexId> wait_vertexes_;
+        std::vector<std::string_view> stop_names_;
+        domain::PerfectHash stop_hash_;
+        std::vector<std::string_view> bus_names_;
         const TransportCatalogue& catalogue_;
+        GraphModel graph_model_ = GraphModel::COMPLETE;
+        Minutes bus_wait_time_ = 0.;
     };
 }
\ No newline at end of file